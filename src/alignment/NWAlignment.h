@@ -10,9 +10,10 @@
 
 #include <sstream>
 
+#include "xasmlib/IntegerVector.h"
 #include "dynamicprogramming/DynamicProgrammingMatrixSolver.h"
 #include "bsp_cpp/bsp_cpp.h"
-#include "util/global_options.h"
+#include "apps/global_options.h"
 
 namespace alignment {
 
@@ -158,6 +159,37 @@ public:
 		return translated;
 	}
 
+	/** number of characters after translation */
+	size_t get_alphasize() const {
+		return alphasize;
+	}
+
+	/** score for character c1 of the first and c2 of the second input */
+	int get_substitution(int c1, int c2) const {
+		return subst_matrix[c2][c1];
+	}
+
+	/** gap scores, _h for gaps in the first input, _v for the second */
+	int get_gap_score_h() const {
+		return gap_score_h;
+	}
+
+	int get_gap_score_v() const {
+		return gap_score_v;
+	}
+
+	int get_gap_continuation_score_h() const {
+		return gap_continuation_score_h;
+	}
+
+	int get_gap_continuation_score_v() const {
+		return gap_continuation_score_v;
+	}
+
+	double get_normalization() const {
+		return normalization;
+	}
+
 	typedef double score_t ;
 	typedef int dp_element_t;
     
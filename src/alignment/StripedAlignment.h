@@ -0,0 +1,424 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+#ifndef __STRIPEDALIGNMENT_H__
+#define __STRIPEDALIGNMENT_H__
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+#ifdef _HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "NWAlignment.h"
+
+namespace alignment {
+
+/**
+ * \brief Striped SIMD alignment with affine gap scores.
+ *
+ * Computes global (Needleman-Wunsch) or local (Smith-Waterman) alignment
+ * scores with Gotoh's affine gap recurrences, using Farrar's striped
+ * query profile. Substitution and gap scores are taken from a
+ * PairwiseScoringOperator. A gap of length k in the first input costs
+ * gap_score_h + (k-1) * gap_continuation_score_h, and correspondingly
+ * with the _v scores for the second input.
+ *
+ * Local scores are computed with 16 unsigned 8-bit lanes first, and
+ * recomputed with 8 signed 16-bit lanes if these saturate. Global scores
+ * use 16-bit lanes. If these overflow too, or if the scores are outside
+ * the range the striped method can handle, a scalar implementation with
+ * 32-bit integers is used.
+ *
+ * The first input is the query, which is striped across the lanes.
+ * When aligning one query to many sequences, set_query should be
+ * called once, followed by score(y) for each sequence.
+ */
+template <class _string = utilities::IntegerVector<8> >
+class StripedAlignment {
+public:
+	typedef _string string;
+
+	StripedAlignment(bool _local = false) : local(_local), lane_bits(0) {
+		PairwiseScoringOperator<_string> op;
+		set_scores(op);
+	}
+
+	StripedAlignment(PairwiseScoringOperator<_string> const & op, bool _local = false) :
+		local(_local), lane_bits(0) {
+		set_scores(op);
+	}
+
+	/** normalized alignment score of x and y, like NWAlignment */
+	double operator() (string const & x, string const & y) {
+		return normalization * score(x, y);
+	}
+
+	/** alignment score of x and y */
+	int score(string const & x, string const & y) {
+		set_query(x);
+		return score(y);
+	}
+
+	/** set the first input and build its query profiles */
+	void set_query(string const & x) {
+		query = x;
+		m = (int)x.size();
+		profiles_valid = false;
+	}
+
+	/** alignment score of the current query and y */
+	int score(string const & y) {
+		int n = (int)y.size();
+		if (m == 0 || n == 0 || !simd_ok) {
+			lane_bits = 32;
+			return score_scalar(y);
+		}
+#ifdef _HAVE_SSE2
+		if (!profiles_valid) {
+			make_profiles();
+		}
+
+		bool overflow = false;
+		int result = 0;
+		if (local && byte_ok) {
+			lane_bits = 8;
+			result = striped_u8(y, overflow);
+			if (!overflow) {
+				return result;
+			}
+		}
+		if (local || global_fits(n)) {
+			lane_bits = 16;
+			result = striped_i16(y, overflow);
+			if (!overflow) {
+				return result;
+			}
+		}
+#endif
+		lane_bits = 32;
+		return score_scalar(y);
+	}
+
+	/** alignment score of the current query and y, without SIMD */
+	int score_scalar(string const & y) {
+		int n = (int)y.size();
+		const int neg_inf = INT_MIN / 2;
+
+		// column 0
+		std::vector<int> & H = s_h;
+		std::vector<int> & E = s_e;
+		H.resize(m + 1);
+		E.resize(m + 1);
+		H[0] = 0;
+		for (int i = 1; i <= m; ++i) {
+			H[i] = local ? 0 : -(o_v + (i-1)*e_v);
+			E[i] = neg_inf;
+		}
+
+		int best = 0;
+		for (int j = 1; j <= n; ++j) {
+			int c = (int)y[j-1];
+			int diag = H[0];
+			H[0] = local ? 0 : -(o_h + (j-1)*e_h);
+			int F = neg_inf;
+			for (int i = 1; i <= m; ++i) {
+				E[i] = std::max(E[i] - e_h, H[i] - o_h);
+				F = std::max(F - e_v, H[i-1] - o_v);
+				int h = std::max(diag + subst[((int)query[i-1])*alphasize + c], std::max(E[i], F));
+				if (local) {
+					h = std::max(h, 0);
+					best = std::max(best, h);
+				}
+				diag = H[i];
+				H[i] = h;
+			}
+		}
+
+		if (!local) {
+			if (m == 0) {
+				return H[0];
+			}
+			return H[m];
+		}
+		return best;
+	}
+
+	/** number of bits per lane used for the last score, 32 means scalar */
+	int get_lane_bits() const {
+		return lane_bits;
+	}
+
+	bool is_local() const {
+		return local;
+	}
+
+private:
+	/** read scores from op and check if they can be used with SIMD */
+	void set_scores(PairwiseScoringOperator<_string> const & op) {
+		alphasize = (int)op.get_alphasize();
+		subst.resize(alphasize*alphasize);
+		max_s = INT_MIN;
+		min_s = INT_MAX;
+		for (int c1 = 0; c1 < alphasize; ++c1) {
+			for (int c2 = 0; c2 < alphasize; ++c2) {
+				int s = op.get_substitution(c1, c2);
+				subst[c1*alphasize + c2] = s;
+				max_s = std::max(max_s, s);
+				min_s = std::min(min_s, s);
+			}
+		}
+
+		// penalties are positive
+		o_h = -op.get_gap_score_h();
+		e_h = -op.get_gap_continuation_score_h();
+		o_v = -op.get_gap_score_v();
+		e_v = -op.get_gap_continuation_score_v();
+		normalization = op.get_normalization();
+
+		// lazy-F evaluation requires that gaps are not cheaper to open
+		// than to continue.
+		simd_ok = e_h >= 0 && e_v >= 0 && o_h >= e_h && o_v >= e_v
+			&& o_h < 1024 && o_v < 1024 && max_s < 1024 && min_s > -1024;
+
+		bias = min_s < 0 ? -min_s : 0;
+		byte_ok = simd_ok && o_h < 256 && o_v < 256 && max_s + bias < 255;
+
+		m = 0;
+		profiles_valid = false;
+	}
+
+	/** true if all global scores stay within 16 bits */
+	bool global_fits(int n) {
+		int worst = (o_v + (m-1)*e_v) + (o_h + (n-1)*e_h);
+		int best = max_s * std::min(m, n);
+		return worst < SHRT_MAX/2 && best < SHRT_MAX/2;
+	}
+
+#ifdef _HAVE_SSE2
+	/** build the striped query profiles */
+	void make_profiles() {
+		seg8 = (m + 15) / 16;
+		seg16 = (m + 7) / 8;
+
+		prof8.resize(alphasize * seg8);
+		prof16.resize(alphasize * seg16);
+		for (int c = 0; c < alphasize; ++c) {
+			unsigned char * p8 = (unsigned char *)&prof8[c*seg8];
+			for (int s = 0; s < seg8; ++s) {
+				for (int k = 0; k < 16; ++k) {
+					int i = k*seg8 + s;
+					int v = i < m ? subst[((int)query[i])*alphasize + c] : 0;
+					p8[s*16 + k] = (unsigned char)(v + bias);
+				}
+			}
+			short * p16 = (short *)&prof16[c*seg16];
+			for (int s = 0; s < seg16; ++s) {
+				for (int k = 0; k < 8; ++k) {
+					int i = k*seg16 + s;
+					p16[s*8 + k] = (short)(i < m ? subst[((int)query[i])*alphasize + c] : 0);
+				}
+			}
+		}
+		profiles_valid = true;
+	}
+
+	/** move F values to the next lane, lane 0 has no predecessor */
+	inline __m128i shift_f(__m128i vF) {
+		vF = _mm_slli_si128(vF, 2);
+		return local ? vF : _mm_insert_epi16(vF, SHRT_MIN, 0);
+	}
+
+	/** local alignment with saturating unsigned 8-bit lanes */
+	int striped_u8(string const & y, bool & overflow) {
+		int n = (int)y.size();
+		int seg = seg8;
+		__m128i vZero = _mm_setzero_si128();
+		__m128i vBias = _mm_set1_epi8((char)bias);
+		__m128i vOh = _mm_set1_epi8((char)o_h);
+		__m128i vEh = _mm_set1_epi8((char)e_h);
+		__m128i vOv = _mm_set1_epi8((char)o_v);
+		__m128i vEv = _mm_set1_epi8((char)e_v);
+		__m128i vMax = vZero;
+
+		h_load.assign(seg, vZero);
+		h_store.assign(seg, vZero);
+		e_store.assign(seg, vZero);
+		__m128i * pl = &h_load[0];
+		__m128i * ps = &h_store[0];
+		__m128i * pe = &e_store[0];
+
+		for (int j = 0; j < n; ++j) {
+			const __m128i * P = &prof8[((int)y[j])*seg];
+			__m128i vF = vZero;
+			__m128i vH = _mm_slli_si128(pl[seg-1], 1);
+
+			for (int s = 0; s < seg; ++s) {
+				vH = _mm_adds_epu8(vH, P[s]);
+				vH = _mm_subs_epu8(vH, vBias);
+				__m128i vE = pe[s];
+				vH = _mm_max_epu8(vH, vE);
+				vH = _mm_max_epu8(vH, vF);
+				vMax = _mm_max_epu8(vMax, vH);
+				ps[s] = vH;
+
+				vE = _mm_subs_epu8(vE, vEh);
+				pe[s] = _mm_max_epu8(vE, _mm_subs_epu8(vH, vOh));
+				vF = _mm_subs_epu8(vF, vEv);
+				vF = _mm_max_epu8(vF, _mm_subs_epu8(vH, vOv));
+				vH = pl[s];
+			}
+
+			// lazy F: propagate vertical gaps across the stripes while
+			// they can improve H
+			vF = _mm_slli_si128(vF, 1);
+			int s = 0;
+			vH = ps[0];
+			while (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_subs_epu8(vF, _mm_subs_epu8(vH, vOv)), vZero)) != 0xffff) {
+				vH = _mm_max_epu8(vH, vF);
+				ps[s] = vH;
+				vMax = _mm_max_epu8(vMax, vH);
+				pe[s] = _mm_max_epu8(pe[s], _mm_subs_epu8(vH, vOh));
+				vF = _mm_subs_epu8(vF, vEv);
+				if (++s >= seg) {
+					s = 0;
+					vF = _mm_slli_si128(vF, 1);
+				}
+				vH = ps[s];
+			}
+			std::swap(pl, ps);
+		}
+
+		unsigned char lanes[16];
+		_mm_storeu_si128((__m128i*)lanes, vMax);
+		int best = *std::max_element(lanes, lanes + 16);
+		// adding to a saturated lane cannot be detected after subtracting
+		// the bias
+		overflow = best + bias + max_s >= 255;
+		return best;
+	}
+
+	/** local or global alignment with saturating signed 16-bit lanes */
+	int striped_i16(string const & y, bool & overflow) {
+		int n = (int)y.size();
+		int seg = seg16;
+		__m128i vZero = _mm_setzero_si128();
+		__m128i vNegInf = _mm_set1_epi16(SHRT_MIN);
+		__m128i vOh = _mm_set1_epi16((short)o_h);
+		__m128i vEh = _mm_set1_epi16((short)e_h);
+		__m128i vOv = _mm_set1_epi16((short)o_v);
+		__m128i vEv = _mm_set1_epi16((short)e_v);
+		__m128i vInit = local ? vZero : vNegInf;
+		__m128i vMax = local ? vZero : vNegInf;
+
+		h_load.resize(seg);
+		h_store.assign(seg, vZero);
+		e_store.assign(seg, vInit);
+		__m128i * pl = &h_load[0];
+		__m128i * ps = &h_store[0];
+		__m128i * pe = &e_store[0];
+
+		// column 0
+		for (int s = 0; s < seg; ++s) {
+			short * h = (short *)&pl[s];
+			for (int k = 0; k < 8; ++k) {
+				int i = k*seg + s + 1;
+				h[k] = (short)(local ? 0 : -(o_v + (i-1)*e_v));
+			}
+			if (!local) {
+				pe[s] = _mm_subs_epi16(pl[s], vOh);
+			}
+		}
+
+		for (int j = 1; j <= n; ++j) {
+			const __m128i * P = &prof16[((int)y[j-1])*seg16];
+			// diagonal value for row 1 is H[0][j-1]
+			int h0_prev = (local || j == 1) ? 0 : -(o_h + (j-2)*e_h);
+			int h0 = local ? 0 : -(o_h + (j-1)*e_h);
+			__m128i vH = _mm_insert_epi16(_mm_slli_si128(pl[seg-1], 2), h0_prev, 0);
+			__m128i vF = local ? vZero : _mm_insert_epi16(vNegInf, std::max(h0 - o_v, SHRT_MIN), 0);
+
+			for (int s = 0; s < seg; ++s) {
+				vH = _mm_adds_epi16(vH, P[s]);
+				__m128i vE = pe[s];
+				vH = _mm_max_epi16(vH, vE);
+				vH = _mm_max_epi16(vH, vF);
+				if (local) {
+					vH = _mm_max_epi16(vH, vZero);
+				}
+				vMax = _mm_max_epi16(vMax, vH);
+				ps[s] = vH;
+
+				vE = _mm_subs_epi16(vE, vEh);
+				pe[s] = _mm_max_epi16(vE, _mm_subs_epi16(vH, vOh));
+				vF = _mm_subs_epi16(vF, vEv);
+				vF = _mm_max_epi16(vF, _mm_subs_epi16(vH, vOv));
+				vH = pl[s];
+			}
+
+			// lazy F: propagate vertical gaps across the stripes while
+			// they can improve H
+			vF = shift_f(vF);
+			int s = 0;
+			vH = ps[0];
+			while (_mm_movemask_epi8(_mm_cmpgt_epi16(vF, _mm_subs_epi16(vH, vOv))) != 0) {
+				vH = _mm_max_epi16(vH, vF);
+				ps[s] = vH;
+				vMax = _mm_max_epi16(vMax, vH);
+				pe[s] = _mm_max_epi16(pe[s], _mm_subs_epi16(vH, vOh));
+				vF = _mm_subs_epi16(vF, vEv);
+				if (++s >= seg) {
+					s = 0;
+					vF = shift_f(vF);
+				}
+				vH = ps[s];
+			}
+			std::swap(pl, ps);
+		}
+
+		short lanes[8];
+		_mm_storeu_si128((__m128i*)lanes, vMax);
+		int best = *std::max_element(lanes, lanes + 8);
+		overflow = best + max_s >= SHRT_MAX;
+
+		if (local) {
+			return best;
+		}
+		short * h = (short *)&pl[(m-1) % seg];
+		return h[(m-1) / seg];
+	}
+#endif
+
+	bool local;
+	int lane_bits; ///< lane width used for the last score
+
+	int alphasize;
+	std::vector<int> subst; ///< subst[c1*alphasize + c2]
+	int max_s, min_s; ///< substitution score range
+	int o_h, e_h, o_v, e_v; ///< gap open and continuation penalties
+	double normalization;
+
+	bool simd_ok; ///< scores can be used with 16-bit lanes
+	bool byte_ok; ///< scores can be used with 8-bit lanes
+	int bias; ///< offset for unsigned 8-bit substitution scores
+
+	string query;
+	int m;
+	bool profiles_valid;
+
+	std::vector<int> s_h, s_e; ///< scalar workspace
+
+#ifdef _HAVE_SSE2
+	int seg8, seg16; ///< stripe lengths
+	std::vector<__m128i> prof8; ///< 8-bit query profile
+	std::vector<__m128i> prof16; ///< 16-bit query profile
+	std::vector<__m128i> h_load, h_store, e_store; ///< striped workspace
+#endif
+};
+
+};
+
+#endif
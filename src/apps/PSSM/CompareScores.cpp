@@ -9,6 +9,7 @@
 #include <boost/accumulators/statistics.hpp>
 
 #include "PSSM_Tool.h"
+#include "ProfileDB.h"
 
 /************************************************************************/
 /* Compare PSSM Scoring functions. Sequential code.                     */
@@ -71,6 +72,7 @@ void PSSM_CompareScoresApp::run( boost::program_options::variables_map & vm ) {
 		
 		add_progress(1);
 	}
+	PSSM_Profile_DB::flush_all();
 	end_progress();
 
 	for (list<string>::iterator it = scores.begin(); it != scores.end(); ++it ) {
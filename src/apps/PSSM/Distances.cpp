@@ -98,70 +98,84 @@ public:
 
 protected:
 
-	static double KD ( pssms::PSSM<4> const & a , pssms::PSSM<4> const & b ) {
-		static pssms::Both_Strands_DNA_Min_KullbackLeibler_Distance d;
-		return d(a, b);
-	}
-
-	static double HD ( pssms::PSSM<4> const & a , pssms::PSSM<4> const & b ) {
-		static pssms::Both_Strands_DNA_Min_Hellinger_Distance d;
-		return d(a, b);
-	}
-
-	boost::function2<double, pssms::PSSM<4> const &, pssms::PSSM<4> const & > distancefun;
+	enum {
+		/** PSSMs per tile, the columns of two tiles should fit into the cache */
+		TILE = 64
+	};
 
 	/** Context variables */
-	int P, N, p, n, my_start, my_end;
+	int P, N, p, my_start, my_end;
 	double * data;
 	distance_t dt;
 
+	/** precomputed columns of the PSSMs my_start..N-1 */
+	std::vector< pssms::PSSM_Distance_Columns<4> > columns;
+	pssms::Fast_Both_Strands_DNA_Min_KullbackLeibler_Distance kd;
+	pssms::Fast_Both_Strands_DNA_Min_Hellinger_Distance hd;
+
 	/** Result output */
 	static bool i_have_the_result;
 	static Distances dists;
 
+	/** number of pairs (j, k) with j < k and j < row */
+	static double pairs_before (int row, int N) {
+		return (double)row * (N - 1) - (double)row * (row - 1) / 2;
+	}
+
+	/** distances between PSSMs in rows j0..j1 and columns k0..k1 with k > j */
+	template <class distance>
+	void tile (distance & d, int j0, int j1, int k0, int k1) {
+		for (int j = j0; j <= j1; ++j) {
+			double * row = data + (j - my_start) * N;
+			for (int k = std::max (k0, j + 1); k <= k1; ++k) {
+				row[k] = d(columns[j], columns[k]);
+			}
+		}
+	}
+
 	void run () {
 		using namespace std;
 		BSP_SCOPE(PSSM_Distances);
 		BSP_BEGIN();
-		
-		switch (dt) {
-		case DIST_HELLINGER:
-			distancefun = &HD;
-			break;
-		default:
-			distancefun = &KD;
-			break;
-		}
-
 
 		P = bsp_nprocs();
 		p = bsp_pid();
 
-		n = ICD(N, P);
-
-		my_start = n * p;
-		my_end = n * (p+1) - 1;
-
+		// both distances are symmetric, so we only compute pairs j < k.
+		// Every processor gets a range of rows with the same number of pairs.
+		{
+			const double pairs = pairs_before (N, N);
+			my_start = 0;
+			while (my_start < N && pairs_before (my_start, N) < pairs * p / P) {
+				++my_start;
+			}
+			my_end = my_start;
+			while (my_end < N && pairs_before (my_end, N) < pairs * (p + 1) / P) {
+				++my_end;
+			}
+			my_end = (p == P - 1) ? N - 1 : my_end - 1;
+		}
 
-		if (my_end >= N) {
-			my_end = N-1;
+		columns.resize(N);
+		for (int j = my_start; j < N; ++j) {
+			columns[j].set(g_pssms[j]);
 		}
 
 		bsp_push_reg(data, N*N*sizeof(double));
 
 		BSP_SYNC();
 
-		int l = 0;
-		for (int j = my_start; j <= my_end; ++j) {
-			for (int k = 0; k < N; ++k) {
-				if (j == k) {
-					data[l*N+k] = 0;
+		for (int j0 = my_start; j0 <= my_end; j0 += TILE) {
+			const int j1 = min (j0 + TILE - 1, my_end);
+			for (int k0 = j0; k0 < N; k0 += TILE) {
+				const int k1 = min (k0 + TILE - 1, N - 1);
+				if (dt == DIST_HELLINGER) {
+					tile (hd, j0, j1, k0, k1);
 				} else {
-					data[l*N+k] = distancefun(g_pssms[j], g_pssms[k]);
+					tile (kd, j0, j1, k0, k1);
 				}
-				add_progress(1);
 			}
-			++l;
+			add_progress( (int) (pairs_before (j1 + 1, N) - pairs_before (j0, N)) );
 		}
 
 		if (bsp_pid() != 0 && my_start <= my_end) {
@@ -172,6 +186,12 @@ protected:
 		bsp_pop_reg(data);
 
 		if ( bsp_pid() == 0 ) {
+			for (int j = 0; j < N; ++j) {
+				data[j*N + j] = 0;
+				for (int k = j + 1; k < N; ++k) {
+					data[k*N + j] = data[j*N + k];
+				}
+			}
 			i_have_the_result = true;
 			dists.resize(N);
 			memcpy(dists.data(), data, N * N * sizeof(double));
@@ -201,7 +221,8 @@ Distances PSSM_Distances::dists;
 	} else {
 		r.set_distance_type(PSSM_Distances::DIST_KULLBACK_LEIBLER);
 	}
-	start_progress("Computing pairwise distances...", (int) ( g_pssms.size() * g_pssms.size() ) );
+	// a single PSSM has no pairs, but the progress bar needs a maximum > 0
+	start_progress("Computing pairwise distances...", std::max(1, (int) ( g_pssms.size() * (g_pssms.size() - 1) / 2 ) ) );
 	r.run();
 	end_progress();
 
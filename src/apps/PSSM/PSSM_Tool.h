@@ -43,6 +43,9 @@ typedef pssms::PSSM_Score_Factory<dnastring, 4> pssmscorefactory;
 /** PSSM Score function type */
 typedef pssmscorefactory::product_t pssmscore;
 
+/** Scans sequences with many PSSMs at once */
+typedef pssms::PSSM_Multi_Scanner<dnastring, 4> pssmscanner;
+
 /** Sequence models are stored in a shared pointer */
 typedef boost::shared_ptr < sequencemodel::SequenceModel< dnastring > > pssmsequencemodel;
 
@@ -72,6 +75,49 @@ public:
 		);
 };
 
+/** A PSSM match found by PSSM_ScoreApp */
+struct Motif_Hit : public datamodel::Serializable {
+	long int five_prime_pos;
+	long int three_prime_pos;
+	double pvalue;
+	double score;
+	std::string name;
+	std::string accession;
+	std::string sequence;
+	std::string strand;
+
+	int _pssm_idx;
+
+	void defaults() {
+		five_prime_pos = -1;
+		three_prime_pos = -1;
+		strand = "positive";
+		sequence = "";
+		name = "";
+		pvalue = DBL_MAX;
+		score = 0;
+	}
+
+	JSONIZE_AS (
+		"Datatypes::Motifs::Motif_Hit",
+		Motif_Hit, 1,
+		S_STORE(name, JSONString<>)
+		S_STORE(accession, JSONString<>)
+		S_STORE(sequence, JSONString<>)
+		S_STORE(strand, JSONString<>)
+		S_STORE(five_prime_pos, JSONInt<long>)
+		S_STORE(three_prime_pos, JSONInt<long>)
+		S_STORE(pvalue, JSONDouble<>)
+		S_STORE(score, JSONDouble<>)
+	);
+};
+
+inline bool operator==(const Motif_Hit & m1, const Motif_Hit & m2) {
+	return m1.name == m2.name &&
+	( (m1.five_prime_pos == m2.five_prime_pos && m1.three_prime_pos == m2.three_prime_pos) ||
+	  (m1.three_prime_pos == m2.five_prime_pos && m1.five_prime_pos == m2.three_prime_pos) );
+}
+
 /** The PSSM Tool works on a set of PSSMs, which are stored here */
 extern std::vector < pssm > g_pssms;
 
@@ -178,6 +224,8 @@ public:
 			 "Name of the input sequence file.")
 			 ("fragmentsize", po::value<size_t>()->default_value(4096),
 			 "Size of the input chunks to read (increase this for larger input sequences).")
+			 ("split", po::value<std::string>()->default_value("auto"),
+			 "How to split work between processors: pssms, sequence, or auto (sequence when there are fewer than 4 PSSMs per processor).")
 			 ("binomial_p", po::value<double>()->default_value(0.05),
 			 "Binomial test p-value limit (-1 to disable test).")
 			 ("verbosity", po::value<int>()->default_value(0),
@@ -188,6 +236,26 @@ public:
 	 }
 	 
 	 void run(boost::program_options::variables_map & vm);
+
+	 /**
+	  * Read the scoring options and the profiles for all PSSMs in g_pssms.
+	  * This must be called before score().
+	  *
+	  * @param vm : the options of this app and of PSSM_ProfileApp
+	  */
+	 static void set_parameters (boost::program_options::variables_map & vm);
+
+	 /**
+	  * Score all PSSMs in g_pssms on a sequence.
+	  *
+	  * @param in         : the sequence input
+	  * @param motifs     : motifs[j] receives the hits for g_pssms[j]
+	  * @param processors : the number of processors, 0 to use all
+	  */
+	 static void score (std::istream & in, std::vector< std::vector<Motif_Hit> > & motifs, int processors = 0);
+
+	 /** free the profiles read by set_parameters */
+	 static void cleanup ();
  };
 
  /**
@@ -6,9 +6,15 @@
 #include "autoconfig.h"
 
 #include "PSSM_Tool.h"
+#include "ProfileDB.h"
+
+#include <set>
 
 #include <boost/filesystem.hpp>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
 #include "datamodel/SerializePrimitives.h"
 
 /************************************************************************/
@@ -22,7 +28,15 @@ void PSSM_ProfileApp::get_profile (
 	std::string const & ppath) {
 	using namespace std;
 	using namespace boost::filesystem;
-		
+
+	PSSM_Profile_DB & db (PSSM_Profile_DB::get(ppath));
+	string key = PSSM_Profile_DB::key(p, g_background_id, scoretype);
+	if (db.find(key, hist)) {
+		return;
+	}
+
+	// profiles used to be stored in one JSON file per PSSM, 
+	// these are imported into the database.
 	path profilepath (ppath);
 	{
 		ostringstream namestr;
@@ -53,36 +67,84 @@ void PSSM_ProfileApp::get_profile (
 		);
 
 		hist.make_histogram ( score.get(), g_background.get() );
-		prof.histograms[scoretype] = hist;
-		
-		std::ofstream p_out ( profilepath.string().c_str() );
-		datamodel::swrite< datamodel::JSONSerializable < PSSM_Profile > > wr; 
-		wr ( p_out, prof );		
 	} else {
 		hist = it->second;
 	}
+	db.add(key, hist);
 }
 
+/**
+ * Makes the profiles for a range of PSSMs.
+ */
+class Profile_Builder {
+public:
+	Profile_Builder (
+		std::vector<size_t> const & _todo,
+		std::string const & _scoretype,
+		std::string const & _ppath) :
+		todo(_todo), scoretype(_scoretype), ppath(_ppath) {}
+
+	void operator() (tbb::blocked_range<size_t> const & range) const {
+		for (size_t j = range.begin(); j != range.end(); ++j) {
+			pssmhistogram hist;
+			PSSM_ProfileApp::get_profile (g_pssms[todo[j]], scoretype, hist, ppath);
+			add_progress(1);
+		}
+	}
+
+private:
+	std::vector<size_t> const & todo;
+	std::string const & scoretype;
+	std::string const & ppath;
+};
+
 void PSSM_ProfileApp::run (boost::program_options::variables_map & vm) {
 	using namespace std;
 	double pval = vm["pval"].as<double>();
 	string scoretype = vm["scoretype"].as<string>();
+	string profiles = vm["profiles"].as<string>();
 		
 	{	// check profiles directory
 		using namespace boost::filesystem;
-		path profilespath (vm["profiles"].as<string>());
+		path profilespath (profiles);
 
 		if (!exists (profilespath) || !is_directory(profilespath) ){
 			throw std::runtime_error ("Profile directory could not be found.");
 		}			
 	}
 
-	start_progress ("Making PSSM profiles...", (int)g_pssms.size());
-	for ( size_t j = 0; j < g_pssms.size(); ++j ) {
-		pssmhistogram hist;
-		get_profile (g_pssms[j], scoretype, hist, vm["profiles"].as<string>());
-		add_progress(1);
+	// PSSMs with the same accession and name have the same key in the
+	// profile database, only compute their histogram once.
+	vector<size_t> todo;
+	{
+		set<string> seen;
+		for ( size_t j = 0; j < g_pssms.size(); ++j ) {
+			string key = g_pssms[j].get_accession() + "_" + g_pssms[j].get_name();
+			if (seen.insert(key).second) {
+				todo.push_back(j);
+			}
+		}
+	}
+
+	// profiles can be computed independently unless the histograms 
+	// are sampled from the background model, which has only one 
+	// random number generator.
+	int order;
+	size_t alphabet;
+	vector<double> probs;
+	bool exact = g_background->get_transition_probabilities(order, alphabet, probs);
+
+	start_progress ("Making PSSM profiles...", (int)todo.size());
+	Profile_Builder builder (todo, scoretype, profiles);
+	if (exact) {
+		tbb::parallel_for(
+			tbb::blocked_range<size_t> (0, todo.size(), 1), 
+			builder,
+			tbb::auto_partitioner()
+		);
+	} else {
+		builder(tbb::blocked_range<size_t> (0, todo.size()));
 	}
+	PSSM_Profile_DB::flush_all();
 	end_progress();
 }
-
@@ -0,0 +1,203 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include <boost/filesystem.hpp>
+
+#include "ProfileDB.h"
+
+namespace {
+	const char db_magic[8] = { 'P', 'S', 'S', 'M', 'P', 'D', 'B', 0 };
+	const UINT32 db_version = 1;
+
+	/** all open databases, by profile directory */
+	std::map<std::string, boost::shared_ptr<PSSM_Profile_DB> > g_databases;
+	tbb::mutex g_databases_mutex;
+};
+
+PSSM_Profile_DB::PSSM_Profile_DB (std::string const & _filename) :
+	filename(_filename), base(NULL), index(NULL), entries(0) {
+	map_file();
+}
+
+PSSM_Profile_DB::~PSSM_Profile_DB () {
+	try {
+		flush();
+	} catch (std::exception & e) {
+		std::cerr << "Could not write profile database " << filename << ": " << e.what() << std::endl;
+	}
+}
+
+std::string PSSM_Profile_DB::key (pssm const & p, std::string const & background, std::string const & scoretype) {
+	return p.get_accession() + "\t" + p.get_name() + "\t" + background + "\t" + scoretype;
+}
+
+bool PSSM_Profile_DB::find (std::string const & key, pssmhistogram & hist) {
+	tbb::mutex::scoped_lock l (mutex);
+	std::map<std::string, std::vector<float> >::const_iterator it = added.find(key);
+	if (it != added.end()) {
+		hist.set_tail_scores(&(it->second[0]), &(it->second[0]) + it->second.size());
+		return true;
+	}
+
+	size_t beg = 0, end = entries;
+	while (beg < end) {
+		size_t mid = (beg + end) / 2;
+		int c = entry_key(mid).compare(key);
+		if (c == 0) {
+			const float * data = (const float *) (base + index[mid].data_offset);
+			hist.set_tail_scores(data, data + PSSM_HIST_NBUCKETS);
+			return true;
+		} else if (c < 0) {
+			beg = mid + 1;
+		} else {
+			end = mid;
+		}
+	}
+	return false;
+}
+
+void PSSM_Profile_DB::add (std::string const & key, pssmhistogram const & hist) {
+	if (hist.get_tail_scores().size() != PSSM_HIST_NBUCKETS) {
+		return;
+	}
+	std::vector<double> const & ts (hist.get_tail_scores());
+	tbb::mutex::scoped_lock l (mutex);
+	added[key].assign(ts.begin(), ts.end());
+}
+
+void PSSM_Profile_DB::flush () {
+	using namespace std;
+	namespace fs = boost::filesystem;
+	tbb::mutex::scoped_lock l (mutex);
+
+	if (added.empty()) {
+		return;
+	}
+
+	// merge file and new entries, sorted by key
+	map<string, const float *> all;
+	for (size_t j = 0; j < entries; ++j) {
+		all[entry_key(j)] = (const float *) (base + index[j].data_offset);
+	}
+	for (map<string, vector<float> >::const_iterator it = added.begin(); it != added.end(); ++it) {
+		all[it->first] = &(it->second[0]);
+	}
+
+	// write to a temporary file first, other processes might be
+	// reading the old one
+	fs::path tmp (filename + "." + fs::unique_path().string());
+	{
+		ofstream out (tmp.string().c_str(), ios::binary);
+		if (!out.good()) {
+			throw runtime_error("Cannot write profile database " + tmp.string());
+		}
+
+		header h;
+		memcpy(h.magic, db_magic, sizeof(h.magic));
+		h.version = db_version;
+		h.nbuckets = PSSM_HIST_NBUCKETS;
+		h.entries = all.size();
+		out.write((const char *)&h, sizeof(header));
+
+		UINT64 data_offset = sizeof(header) + all.size() * sizeof(entry);
+		UINT64 key_offset = data_offset + all.size() * PSSM_HIST_NBUCKETS * sizeof(float);
+		for (map<string, const float *>::const_iterator it = all.begin(); it != all.end(); ++it) {
+			entry e;
+			e.key_offset = key_offset;
+			e.key_length = it->first.size();
+			e.data_offset = data_offset;
+			out.write((const char *)&e, sizeof(entry));
+			key_offset += it->first.size();
+			data_offset += PSSM_HIST_NBUCKETS * sizeof(float);
+		}
+		for (map<string, const float *>::const_iterator it = all.begin(); it != all.end(); ++it) {
+			out.write((const char *)it->second, PSSM_HIST_NBUCKETS * sizeof(float));
+		}
+		for (map<string, const float *>::const_iterator it = all.begin(); it != all.end(); ++it) {
+			out.write(it->first.c_str(), it->first.size());
+		}
+		if (!out.good()) {
+			throw runtime_error("Cannot write profile database " + tmp.string());
+		}
+	}
+
+	// the old file must be unmapped before it can be replaced
+	all.clear();
+	region.reset();
+	mapping.reset();
+	base = NULL;
+	index = NULL;
+	entries = 0;
+
+	fs::rename(tmp, fs::path(filename));
+	added.clear();
+	map_file();
+}
+
+PSSM_Profile_DB & PSSM_Profile_DB::get (std::string const & ppath) {
+	tbb::mutex::scoped_lock l (g_databases_mutex);
+	boost::shared_ptr<PSSM_Profile_DB> & db (g_databases[ppath]);
+	if (!db) {
+		boost::filesystem::path p (ppath);
+		p /= "profiles.db";
+		db = boost::shared_ptr<PSSM_Profile_DB> (new PSSM_Profile_DB(p.string()));
+	}
+	return *db;
+}
+
+void PSSM_Profile_DB::flush_all () {
+	tbb::mutex::scoped_lock l (g_databases_mutex);
+	for (std::map<std::string, boost::shared_ptr<PSSM_Profile_DB> >::iterator it = g_databases.begin();
+		it != g_databases.end(); ++it) {
+		it->second->flush();
+	}
+}
+
+void PSSM_Profile_DB::map_file () {
+	using namespace std;
+	using namespace boost::interprocess;
+	namespace fs = boost::filesystem;
+
+	if (!fs::exists(filename) || fs::file_size(filename) < sizeof(header)) {
+		return;
+	}
+	const UINT64 size = fs::file_size(filename);
+
+	mapping = boost::shared_ptr<file_mapping> (new file_mapping(filename.c_str(), read_only));
+	region = boost::shared_ptr<mapped_region> (new mapped_region(*mapping, read_only));
+	base = (const char *) region->get_address();
+
+	header const * h = (header const *) base;
+	if (memcmp(h->magic, db_magic, sizeof(h->magic)) != 0
+	 || h->version != db_version
+	 || h->nbuckets != PSSM_HIST_NBUCKETS
+	 || h->entries > (size - sizeof(header)) / sizeof(entry)) {
+		cerr << "Ignoring incompatible profile database " << filename << endl;
+		return;
+	}
+
+	const entry * e = (const entry *) (base + sizeof(header));
+	for (size_t j = 0; j < h->entries; ++j) {
+		if (   e[j].data_offset + PSSM_HIST_NBUCKETS * sizeof(float) > size
+			|| e[j].key_offset + e[j].key_length > size
+			|| e[j].data_offset % sizeof(float) != 0 ) {
+			cerr << "Ignoring damaged profile database " << filename << endl;
+			return;
+		}
+	}
+	index = e;
+	entries = (size_t) h->entries;
+}
+
+std::string PSSM_Profile_DB::entry_key (size_t j) const {
+	return std::string(base + index[j].key_offset, (size_t)index[j].key_length);
+}
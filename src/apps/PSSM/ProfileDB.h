@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __PSSM_ProfileDB_H__
+#define __PSSM_ProfileDB_H__
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <tbb/mutex.h>
+
+#include "PSSM_Tool.h"
+
+/**
+ * Binary database of PSSM score histograms.
+ *
+ * All profiles in a profile directory are stored in one file, which is
+ * mapped into memory. The file has a header, an index of keys sorted
+ * by key, the tail scores of all histograms (as floats, which keeps
+ * enough precision for p-values), and the key strings. A lookup is a
+ * binary search in the index.
+ *
+ * New histograms are kept in memory until flush() writes a new file
+ * and replaces the old one.
+ */
+class PSSM_Profile_DB {
+public:
+	/** open a database file, which need not exist yet */
+	PSSM_Profile_DB (std::string const & _filename);
+
+	/** flushes new profiles */
+	~PSSM_Profile_DB ();
+
+	/** the key of the profile for a PSSM, background model and score type */
+	static std::string key (pssm const & p, std::string const & background, std::string const & scoretype);
+
+	/**
+	 * Look up a histogram
+	 *
+	 * @param key  the profile key
+	 * @param hist receives the histogram
+	 * @return false if the key is not in the database
+	 */
+	bool find (std::string const & key, pssmhistogram & hist);
+
+	/** add a histogram, this is written to the file by flush() */
+	void add (std::string const & key, pssmhistogram const & hist);
+
+	/** write the database file if any histograms were added */
+	void flush ();
+
+	/** get the database in a profile directory */
+	static PSSM_Profile_DB & get (std::string const & ppath);
+
+	/** flush the databases of all profile directories */
+	static void flush_all ();
+
+private:
+	/** file header */
+	struct header {
+		char magic[8];
+		UINT32 version;
+		UINT32 nbuckets;
+		UINT64 entries;
+	};
+
+	/** index entry, offsets are from the start of the file */
+	struct entry {
+		UINT64 key_offset;
+		UINT64 key_length;
+		UINT64 data_offset;
+	};
+
+	/** map the database file and check its header and index */
+	void map_file ();
+
+	/** key of index entry j */
+	std::string entry_key (size_t j) const;
+
+	std::string filename;
+	tbb::mutex mutex;
+
+	boost::shared_ptr<boost::interprocess::file_mapping> mapping;
+	boost::shared_ptr<boost::interprocess::mapped_region> region;
+	const char * base;
+	const entry * index;
+	size_t entries;
+
+	/** histograms which are not in the file yet */
+	std::map<std::string, std::vector<float> > added;
+};
+
+#endif // __PSSM_ProfileDB_H__
@@ -6,17 +6,21 @@
 #include "autoconfig.h"
 
 #include "PSSM_Tool.h"
+#include "ProfileDB.h"
 
 #include <vector>
 #include <algorithm>
 
 #include <boost/filesystem.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/icl/interval_map.hpp>
 #include <boost/math/distributions/binomial.hpp>
 
 #include <tbb/spin_mutex.h>
 #include <tbb/concurrent_queue.h>
 #include <tbb/concurrent_vector.h>
+#include <tbb/tbb_thread.h>
+#include <tbb/atomic.h>
 
 #include "datamodel/SequenceTranslation.h"
 
@@ -24,48 +28,6 @@
 /* Score PSSM matrices                                                  */
 /************************************************************************/
 
-struct Motif_Hit : public datamodel::Serializable {
-	long int five_prime_pos;
-	long int three_prime_pos;
-	double pvalue;
-	double score;
-	std::string name;
-	std::string accession;
-	std::string sequence;
-	std::string strand;
-
-	int _pssm_idx;
-
-	void defaults() {
-		five_prime_pos = -1;
-		three_prime_pos = -1;
-		strand = "positive";
-		sequence = "";
-		name = "";
-		pvalue = DBL_MAX;
-		score = 0;
-	}
-
-	JSONIZE_AS (
-		"Datatypes::Motifs::Motif_Hit",
-		Motif_Hit, 1,
-		S_STORE(name, JSONString<>)
-		S_STORE(accession, JSONString<>)
-		S_STORE(sequence, JSONString<>)
-		S_STORE(strand, JSONString<>)
-		S_STORE(five_prime_pos, JSONInt<long>)
-		S_STORE(three_prime_pos, JSONInt<long>)
-		S_STORE(pvalue, JSONDouble<>)
-		S_STORE(score, JSONDouble<>)
-	);
-};
-
-inline bool operator==(const Motif_Hit & m1, const Motif_Hit & m2) {
-	return m1.name == m2.name &&
-	( (m1.five_prime_pos == m2.five_prime_pos && m1.three_prime_pos == m2.three_prime_pos) ||
-	  (m1.three_prime_pos == m2.five_prime_pos && m1.five_prime_pos == m2.three_prime_pos) );
-}
-
 struct Motif_Presence : public datamodel::Serializable {
 	double pvalue;
 	int count;
@@ -101,11 +63,171 @@ static tbb::concurrent_queue<Motif_Hit> g_motif_queue;
 /** the number of scores we collected for each PSSM. */
 tbb::concurrent_vector<int> g_scores_collected;
 
+/**
+ * Turns scanner hits into Motif_Hits and adds them to g_motif_queue.
+ *
+ * Scanner index m is PSSM first_pssm + m/2, on the positive strand
+ * for even m and the negative strand for odd m.
+ */
+struct Motif_Hit_Collector {
+	Motif_Hit_Collector(
+		dnastring const & _sequence,
+		int _pos,
+		int _first_pssm,
+		int _end,
+		tbb::concurrent_vector<pssmhistogram*> & _profile_cache
+	) : sequence(_sequence), pos(_pos),
+		first_pssm(_first_pssm), end(_end), profile_cache(_profile_cache) {}
+
+	void operator() (int m, int k, double score) {
+		// windows starting at end are reported by the next processor
+		if (k >= end) {
+			return;
+		}
+		int j = first_pssm + m/2;
+		pssm & p = g_pssms[j];
+		size_t len = p.get_length();
+		pssmhistogram & px (*profile_cache[j]);
+		dnastring testvec;
+		sequence.extract_substring (k, k + len-1, testvec );
+
+		long int fpp, tpp;
+		std::string strnd;
+
+		if (m % 2 == 0) {
+			strnd = "positive";
+			fpp = pos+k;
+			tpp = (long) ( pos+k+len-1 );
+		} else {
+			strnd = "negative";
+			fpp = (long) ( pos+k+len-1 );
+			tpp = pos+k;
+			datamodel::reverse_complement<8>(testvec, 4);
+		}
+
+		Motif_Hit hit;
+		hit._pssm_idx = j;
+		hit.name = p.get_name();
+		hit.accession = p.get_accession();
+		hit.five_prime_pos = fpp;
+		hit.three_prime_pos = tpp;
+		hit.strand = strnd;
+		hit.score = score;
+		hit.pvalue = px.right_tail(score);
+		hit.sequence = datamodel::unwrap_sequence<8>(testvec, "ACGT", 'N');
+
+		g_motif_queue.push (hit);
+	}
+
+	dnastring const & sequence;
+	int pos;
+	int first_pssm;
+	int end;
+	tbb::concurrent_vector<pssmhistogram*> & profile_cache;
+};
+
+/**
+ * Reads sequence fragments in a producer thread.
+ *
+ * Reading and translating the next fragments happens while the
+ * current one is scored. Fragments are passed through a fixed ring of
+ * buffers: the producer takes free buffers, fills them using a
+ * WindowedInputStream, and queues them for the consumer, which gives
+ * them back using release().
+ */
+class Fragment_Reader {
+public:
+	struct fragment {
+		dnastring sequence;
+		int pos;
+		size_t read;
+	};
+
+	/**
+	 * Start reading
+	 *
+	 * @param in           : the input stream
+	 * @param overlap      : overlap between consecutive fragments
+	 * @param fragmentsize : size of the fragments
+	 * @param nbuffers     : number of buffers in the ring
+	 */
+	Fragment_Reader(std::istream & in, size_t overlap, size_t _fragmentsize, size_t nbuffers = 3)
+		: stream(in, "ACGTN"), winstr(overlap), fragmentsize(_fragmentsize), buffers(nbuffers) {
+		winstr.set_input(stream);
+		stop = false;
+		for (size_t j = 0; j < nbuffers; ++j) {
+			free_buffers.push(&buffers[j]);
+		}
+		producer = new tbb::tbb_thread(produce, this);
+	}
+
+	~Fragment_Reader() {
+		// the producer may be waiting for a free buffer
+		stop = true;
+		free_buffers.push(NULL);
+		producer->join();
+		delete producer;
+	}
+
+	/**
+	 * Get the next fragment, this blocks until it has been read.
+	 * At the end of the input, a fragment with read == 0 is returned.
+	 */
+	fragment * next() {
+		fragment * f;
+		full_buffers.pop(f);
+		if (error != "") {
+			throw std::runtime_error(error);
+		}
+		return f;
+	}
+
+	/** give a fragment back after it has been used */
+	void release(fragment * f) {
+		free_buffers.push(f);
+	}
+
+private:
+	static void produce(Fragment_Reader * r) {
+		for (;;) {
+			fragment * f;
+			r->free_buffers.pop(f);
+			if (r->stop || f == NULL) {
+				break;
+			}
+			try {
+				f->read = r->winstr.get_window(r->fragmentsize, f->sequence, f->pos);
+			} catch (std::exception & e) {
+				r->error = e.what();
+				f->read = 0;
+			}
+			f->sequence.resize(f->read);
+			r->full_buffers.push(f);
+			if (f->read == 0) {
+				break;
+			}
+		}
+	}
+
+	datamodel::TranslatingInputStream<8> stream;
+	datamodel::WindowedInputStream<8> winstr;
+	size_t fragmentsize;
+
+	std::vector<fragment> buffers;
+	tbb::concurrent_bounded_queue<fragment*> free_buffers;
+	tbb::concurrent_bounded_queue<fragment*> full_buffers;
+	tbb::tbb_thread * producer;
+	tbb::atomic<bool> stop;
+	/** set by the producer before queueing the last fragment */
+	std::string error;
+};
+
 /** Parallel PSSM Scorer */
 class PSSM_Scorer : public bsp::Context {
 public:
 	PSSM_Scorer() {
 		CONTEXT_SHARED_INIT(pos, int);
+		CONTEXT_SHARED_INIT(read, int);
 		CONTEXT_SHARED_INIT(current_sequence, dnastring);
 	}
 
@@ -115,6 +237,10 @@ public:
 
 		pval = vm["pval"].as<double>();
 		fragmentsize = vm["fragmentsize"].as<size_t>();
+		split = vm["split"].as<std::string>();
+		if (split != "auto" && split != "pssms" && split != "sequence") {
+			throw std::runtime_error("Unknown work split (allowed: auto / pssms / sequence)");
+		}
 
 		overlap_size = 1;
 		N = (int)g_pssms.size();
@@ -133,6 +259,7 @@ public:
 			minscores[j] = phi->right_tail_min_score(pval);
 			g_scores_collected[j] = 0;
 		}
+		PSSM_Profile_DB::flush_all();
 		histograms_read = true;
 		end_progress();
 	}
@@ -142,6 +269,15 @@ public:
 		in = &_in;
 	}
 
+	/**
+	 * True if each processor should score all PSSMs on a part of each
+	 * fragment rather than some PSSMs on all of it. With only a few
+	 * PSSMs, splitting by PSSMs leaves most processors idle.
+	 */
+	static bool split_by_sequence(int nprocs) {
+		return split == "sequence" || (split == "auto" && N < 4*nprocs);
+	}
+
 	static void cleanup_profiles() {
 		for (size_t j = 0; j < g_pssms.size(); ++j) {
 			delete profile_cache[j];
@@ -152,16 +288,23 @@ public:
 
 protected:
 
-	/** Problem splitting (N/P pssms per processor) */
+	/** Problem splitting (N/P pssms per processor, or all pssms on 1/P of each fragment) */
 	int n, P, p;
 	int  my_start, my_end;
+	bool by_sequence;
 
 	/** Current global sequence position */
 	int pos;
 
+	/** number of characters read in the current step, 0 at the end of the input */
+	int read;
+
 	/** in each step, we read sequence into this and broadcast */
 	dnastring current_sequence;
 
+	/** scans the PSSMs my_start..my_end on both strands */
+	pssmscanner scanner;
+
 	/** Number of PSSMs */
 	static int N;
 
@@ -183,6 +326,9 @@ protected:
 	/** the score type and profiles directory */
 	static std::string scoretype, profiles;
 
+	/** how to split work between processors: auto, pssms or sequence */
+	static std::string split;
+
 	/** the profile cache */
 	static tbb::concurrent_vector<pssmhistogram*> profile_cache;
 
@@ -196,33 +342,57 @@ protected:
 
 		BSP_BEGIN();
 		P = bsp_nprocs();
-		n = ICD(N, P);
 		p = bsp_pid();
+		by_sequence = split_by_sequence(P);
 
-		my_start = p*n;
-		my_end = (p+1)*n - 1;
-		if (my_end >= N) {
+		if (by_sequence) {
+			my_start = 0;
 			my_end = N-1;
+		} else {
+			n = ICD(N, P);
+			my_start = p*n;
+			my_end = (p+1)*n - 1;
+			if (my_end >= N) {
+				my_end = N-1;
+			}
+		}
+
+		scanner.clear();
+		for (int j = my_start; j <= my_end; ++j) {
+			pssmscanner::score_t sc (g_pssms[j],
+				pssmscorefactory::pseudocount(pssmscorefactory::s(scoretype.c_str())));
+			scanner.add(sc, minscores[j]);
+			scanner.add_reverse_complement(sc, minscores[j]);
 		}
 
 		BSP_END();
 		end_progress();
 
-		datamodel::TranslatingInputStream<8> stream (*in, "ACGTN");
-		datamodel::WindowedInputStream<8> winstr ( overlap_size );
-		winstr.set_input ( stream );
+		// when splitting by sequence, every processor gets
+		// fragmentsize characters
+		size_t fs = fragmentsize;
+		if (split_by_sequence(::bsp_nprocs())) {
+			fs *= ::bsp_nprocs();
+		}
+		// only processor 0 reads the input
+		boost::scoped_ptr<Fragment_Reader> reader;
+		if ( ::bsp_pid() == 0 ) {
+			reader.reset(new Fragment_Reader (*in, overlap_size, fs));
+		}
 
 		pos = 0;
 		for(int j = 0; j < N; ++j) {
 			g_scores_collected[j] = 0;
 		}
-		current_sequence.resize( overlap_size );
 
-		size_t read = 0;
+		read = 0;
 		do {
 			if ( ::bsp_pid() == 0 ) {
-				read = winstr.get_window(fragmentsize, current_sequence, pos);
-				current_sequence.resize(read);
+				Fragment_Reader::fragment * f = reader->next();
+				read = (int)f->read;
+				pos = f->pos;
+				current_sequence = f->sequence;
+				reader->release(f);
 				std::ostringstream s;
 				s << "Read pos:" << pos << " (" << read << " chars)" << std::endl;
 				if (read > 0) {
@@ -232,56 +402,34 @@ protected:
 
 			BSP_BROADCAST(current_sequence, 0);
 			BSP_BROADCAST(pos, 0);
+			BSP_BROADCAST(read, 0);
 			BSP_BEGIN();
 
-			if (current_sequence.size() > 0) {
-				for (int j = my_start; j <= my_end; ++j) {
-					pssm & p = g_pssms[j];
-					size_t len = p.get_length();
-					double minscore = minscores[j];
-					pssmscore scfun = pssmscorefactory::create(p, pssmscorefactory::s(scoretype.c_str()));
-
-					for (int strand = 0; strand < 2; ++strand) {
-						for (int k = 0; k < current_sequence.size() - len; ++k) {
-							++g_scores_collected[j];
-							double score = scfun->score(current_sequence, k);
-							if (score > minscore) {
-								pssmhistogram & px (*profile_cache[j]);
-								dnastring testvec;
-								current_sequence.extract_substring (k, k + len-1, testvec );
-
-								long int fpp, tpp;
-								std::string strnd;
-
-								if (strand == 0) {
-									strnd = "positive";
-									fpp = pos+k;
-									tpp = (long) ( pos+k+len-1 );
-								} else {
-									strnd = "negative";
-									fpp = (long) (pos + (current_sequence.size() - 1 - k ));
-									tpp = (long) (pos + (current_sequence.size() - 1 - (k+len-1) ) );
-								}
-
-								Motif_Hit hit;
-								hit._pssm_idx = j;
-								hit.name = p.get_name();
-								hit.accession = p.get_accession();
-								hit.five_prime_pos = fpp;
-								hit.three_prime_pos = tpp;
-								hit.strand = strnd;
-								hit.score = score;
-								hit.pvalue = px.right_tail(score);
-								hit.sequence = datamodel::unwrap_sequence<8>(testvec, "ACGT", 'N');
-
-								g_motif_queue.push (hit);
-							}
+			if (current_sequence.size() > 0 && scanner.size() > 0) {
+				// both strands are scanned in one pass on the forward
+				// sequence. The next fragment starts fs - overlap_size
+				// characters further on, windows starting there are
+				// scored as part of it.
+				const int size = (int)current_sequence.size();
+				const int ws = std::min(size, (int)(fs - overlap_size));
+				int a = 0, b = ws;
+				if (by_sequence) {
+					int nb = ICD(ws, P);
+					a = std::min(p*nb, ws);
+					b = std::min(a + nb, ws);
+				}
+				Motif_Hit_Collector collect (current_sequence, pos, my_start, b, profile_cache);
+				scanner.scan(current_sequence, a,
+					std::min(b + scanner.get_max_length() - 1, size), collect);
+
+				if ( ::bsp_pid() == 0 ) {
+					for (int j = 0; j < N; ++j) {
+						int count = std::min(ws, size - (int)g_pssms[j].get_length() + 1);
+						if (count > 0) {
+							g_scores_collected[j] += 2*count;
 						}
-						datamodel::reverse_complement<8>(current_sequence, 4);
-					}
-					if ( ::bsp_pid() == 0 ) {
-						add_progress(1);
 					}
+					add_progress(N);
 				}
 			}
 
@@ -296,7 +444,7 @@ protected:
 tbb::concurrent_vector<double> PSSM_Scorer::minscores;
 tbb::concurrent_vector<pssmhistogram*> PSSM_Scorer::profile_cache;
 std::istream * PSSM_Scorer::in = NULL;
-std::string PSSM_Scorer::scoretype, PSSM_Scorer::profiles;
+std::string PSSM_Scorer::scoretype, PSSM_Scorer::profiles, PSSM_Scorer::split;
 double PSSM_Scorer::pval;
 int PSSM_Scorer::N;
 size_t PSSM_Scorer::fragmentsize, PSSM_Scorer::overlap_size;
@@ -318,8 +466,7 @@ void PSSM_ScoreApp::run (boost::program_options::variables_map & vm) {
 	vector<string> paths;
 	TextIO::split(p, paths, ":");
 
-	bsp::Runner<PSSM_Scorer> r;
-	r.set_parameters(vm);
+	set_parameters(vm);
 
 	for (size_t j = 0; j < paths.size(); ++j) {
 		try {
@@ -345,17 +492,8 @@ void PSSM_ScoreApp::run (boost::program_options::variables_map & vm) {
 
             std::ifstream f (inpath.c_str());
 
-			r.set_sequence_input(f);
-			r.run();
-
 			std::vector< std::vector<Motif_Hit> > motifs;
-
-			motifs.resize( g_pssms.size() );
-
-			Motif_Hit hit;
-			while (g_motif_queue.try_pop(hit)) {
-				motifs[hit._pssm_idx].push_back(hit);
-			}
+			score(f, motifs);
 
             std::ofstream fout((inpath.string() + ".motifs.json").c_str());
 			bool printed_one = false;
@@ -477,6 +615,33 @@ void PSSM_ScoreApp::run (boost::program_options::variables_map & vm) {
 		}
 	}
 
-	r.cleanup_profiles();
+	cleanup();
+}
+
+void PSSM_ScoreApp::set_parameters (boost::program_options::variables_map & vm) {
+	PSSM_Scorer::set_parameters(vm);
+}
+
+void PSSM_ScoreApp::score (std::istream & in, std::vector< std::vector<Motif_Hit> > & motifs, int processors) {
+	boost::scoped_ptr< bsp::Runner<PSSM_Scorer> > r;
+	if (processors > 0) {
+		r.reset(new bsp::Runner<PSSM_Scorer> (processors));
+	} else {
+		r.reset(new bsp::Runner<PSSM_Scorer>);
+	}
+	PSSM_Scorer::set_sequence_input(in);
+	r->run();
+
+	motifs.clear();
+	motifs.resize( g_pssms.size() );
+
+	Motif_Hit hit;
+	while (g_motif_queue.try_pop(hit)) {
+		motifs[hit._pssm_idx].push_back(hit);
+	}
+}
+
+void PSSM_ScoreApp::cleanup () {
+	PSSM_Scorer::cleanup_profiles();
 }
 
@@ -166,6 +166,29 @@ public:
 			profile_b[w.x1] = max(profile_b[w.x1], w.score);
 		}
 	}
+
+	/**
+	 * from windowlocal::window_reporter
+	 *
+	 * Once the window queue is full, windows below its minimum score
+	 * will not be stored. When AlignmentPlot::early_abandon is set, we
+	 * let the matchers skip these. The score histogram and profiles
+	 * then only contain the windows which were computed.
+	 */
+	double score_threshold() {
+		static bool early_abandon =
+			bsp::global_option<int>("AlignmentPlot::early_abandon", 0) != 0;
+
+		if (!early_abandon || windows.size() < windows.get_max_size()) {
+			return -DBL_MAX;
+		}
+
+		double t = windows.get_min_key();
+		if(translate.get() != NULL) {
+			t = translate->untranslate_score(t);
+		}
+		return t;
+	}
 	
 	/** from bsp::Reduceable */
 	void make_neutral() {
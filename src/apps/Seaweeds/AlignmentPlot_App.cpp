@@ -6,14 +6,18 @@
 #include "autoconfig.h"
 
 #include <boost/shared_array.hpp>
+#include <boost/filesystem.hpp>
 #include <fstream>
 
 #include "bsp_cpp/bsp_cpp.h"
 #include "AlignmentPlot_App.h"
 
 #include "Methods/AlignmentPlot_Method.h"
+#include "Methods/AlignmentPlot_Tuning.h"
 #include "AlignmentPlotIO.h"
 
+#include "seaweeds/ArchiveCache.h"
+
 #include <tbb/mutex.h>
 
 tbb::mutex ap_output_mutex;
@@ -161,6 +165,23 @@ void AlignmentPlot_App::run( boost::program_options::variables_map & vm ) {
 			seq1.length(), seq2.length());
 	}
 
+	/* seaweed permutations can be cached on disk between runs */
+	std::string const & archive_cache = 
+		bsp::global_option<std::string>("Seaweeds::archive_cache", "");
+	if (!archive_cache.empty() && bsp_pid() == 0) {
+		boost::system::error_code ec;
+		boost::filesystem::create_directories(archive_cache, ec);
+	}
+	seaweeds::ArchiveCache::set_directory(archive_cache);
+
+	/* choose the fastest method for this window length */
+	if (method == "auto") {
+		if(bsp_pid() == 0) {
+			method = tune_alignmentplot_method(seq1, seq2, windowlength);
+		}
+		bsp::bsp_broadcast(0, method);
+	}
+
 	/** cap number of processors for very short sequences */
 	if(processors > ((int)seq1.length() - windowlength + 1)) {
 		processors = (int)seq1.length() - windowlength + 1;
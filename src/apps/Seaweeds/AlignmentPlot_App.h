@@ -50,7 +50,8 @@ public:
 				"The minimum window score required to report a window. Default is 1.0.")
 			(	"method,m",
 				po::value< string >()-> default_value("seaweeds"),
-				"choose method to use: [blcs|seaweeds|nw] (default: seaweeds)" )
+				"choose method to use: [blcs|seaweeds|nw|auto] (default: seaweeds). "
+				"auto times the methods in AlignmentPlot::auto_methods on a sample of the input." )
 		;
 
 		all_opts.add(desc).add(hidden);
@@ -22,3 +22,8 @@ boost::shared_ptr<AlignmentPlot_Method> AlignmentPlot_Method::get_method(
 	return methods[name]->create(ap);
 }
 
+
+/** check if a method with the given name exists */
+bool AlignmentPlot_Method::has_method(std::string const & name) {
+	return methods.find(name) != methods.end();
+}
@@ -6,6 +6,8 @@
 #ifndef __ALIGNMENTPLOT_METHOD_H__
 #define __ALIGNMENTPLOT_METHOD_H__
 
+#include <climits>
+
 #include "../AlignmentPlot.h"
 
 class AlignmentPlot_Method;
@@ -42,10 +44,18 @@ public:
 		int offset1 = 0,
 		int offset2 = 0) = 0;
 
+	/** the maximum window length this method can handle */
+	virtual int get_max_windowlength() {
+		return INT_MAX;
+	}
+
 	/** factory method : create a new method given an alignment plot & */
 	static AlignmentPlot_Method_Ptr get_method(
 		std::string const & name, AlignmentPlot  & );
 
+	/** check if a method with the given name exists */
+	static bool has_method(std::string const & name);
+
 	/** add a method. _apf must be derived from AlignmentPlot_Method_Factory */
 	template <class _apf>
 	static void add_method(const char * name) {
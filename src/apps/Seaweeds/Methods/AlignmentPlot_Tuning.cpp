@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cfloat>
+
+#include <boost/algorithm/string.hpp>
+
+#include "AlignmentPlot_Tuning.h"
+
+/** time running p.method with window length w on p.s1 vs. p.s2 */
+double AlignmentPlot_Benchmark::operator() (int w, parameter & p) {
+	AlignmentPlot ap(
+		(int)p.s1.length(),
+		(int)p.s2.length(),
+		w,
+		0,
+		w+0.1
+	);
+	AlignmentPlot_Method_Ptr apm =
+		AlignmentPlot_Method::get_method(p.method, ap);
+
+	double t0 = bsp_time();
+	apm->run(p.s1, p.s2);
+	return bsp_time() - t0;
+}
+
+namespace {
+	/** profile key for a window length and the current alphabets */
+	std::string profile_key(int w) {
+		using namespace bsp;
+		std::string s1_chars = "ACGTN_";
+		std::string s2_chars = "ACGT_N";
+
+		global_options.get("Seaweeds::s1_chars", s1_chars, s1_chars);
+		global_options.get("Seaweeds::s2_chars", s2_chars, s2_chars);
+
+		std::ostringstream key;
+		key << w << " " << s1_chars << " " << s2_chars;
+		return key.str();
+	}
+
+	/** look up a window length in the profile, return "" if not found */
+	std::string read_profile(std::string const & filename, std::string const & key) {
+		std::ifstream in(filename.c_str());
+		std::string line, result;
+		while (std::getline(in, line)) {
+			size_t split = line.find_last_of(' ');
+			if (split != std::string::npos && line.substr(0, split) == key) {
+				// later entries override earlier ones
+				result = line.substr(split + 1);
+			}
+		}
+		return result;
+	}
+};
+
+/** choose the fastest alignment plot method on this machine */
+std::string tune_alignmentplot_method(
+	std::string const & s1,
+	std::string const & s2,
+	int w) {
+	using namespace std;
+	using namespace bsp;
+
+	string methods = "seaweeds,blcs";
+	string profile = "";
+	int windows = 16;
+	int length = 50000;
+
+	global_options.get("AlignmentPlot::auto_methods", methods, methods);
+	global_options.get("AlignmentPlot::tuning_profile", profile, profile);
+	global_options.get("AlignmentPlot::auto_windows", windows, windows);
+	global_options.get("AlignmentPlot::auto_length", length, length);
+
+	string key = profile_key(w);
+	if (profile != "") {
+		string m = read_profile(profile, key);
+		if (m != "" && AlignmentPlot_Method::has_method(m)) {
+			cout << "Tuning profile " << profile << ": using method " << m << endl;
+			return m;
+		}
+	}
+
+	AlignmentPlot_Benchmark::parameter p;
+	p.s1 = s1.substr(0, windows + w - 1);
+	p.s2 = s2.substr(0, max(length, w));
+
+	vector<string> candidates;
+	boost::split(candidates, methods, boost::is_any_of(","));
+
+	AlignmentPlot_Benchmark benchmark;
+	string best = "";
+	double best_time = DBL_MAX;
+	for (size_t j = 0; j < candidates.size(); ++j) {
+		p.method = boost::trim_copy(candidates[j]);
+		if (!AlignmentPlot_Method::has_method(p.method)) {
+			cerr << "Skipping unknown method " << p.method << endl;
+			continue;
+		}
+		{
+			AlignmentPlot ap;
+			if (w > AlignmentPlot_Method::get_method(p.method, ap)->get_max_windowlength()) {
+				cout << "Tuning: " << p.method << " does not support w = " << w << endl;
+				continue;
+			}
+		}
+
+		double t = benchmark(w, p);
+		cout << "Tuning: " << p.method << " " << t << "s" << endl;
+		if (t < best_time) {
+			best_time = t;
+			best = p.method;
+		}
+	}
+
+	if (best == "") {
+		bsp_abort("No method in AlignmentPlot::auto_methods supports w = %i", w);
+	}
+
+	cout << "Tuning: using method " << best << endl;
+
+	if (profile != "") {
+		ofstream out(profile.c_str(), ios::app);
+		out << key << " " << best << endl;
+	}
+	return best;
+}
@@ -0,0 +1,55 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __ALIGNMENTPLOT_TUNING_H__
+#define __ALIGNMENTPLOT_TUNING_H__
+
+#include <string>
+
+#include "AlignmentPlot_Method.h"
+
+/**
+ * Benchmark for an alignment plot method on sample input.
+ *
+ * This has the benchmark interface used by Tuning<>, so crossover
+ * window lengths between two methods can also be found with
+ * Tuning<AlignmentPlot_Benchmark, AlignmentPlot_Benchmark, ...>::tune
+ */
+class AlignmentPlot_Benchmark {
+public:
+	struct parameter {
+		std::string method;
+		std::string s1;
+		std::string s2;
+	};
+
+	/** time running p.method with window length w on p.s1 vs. p.s2 */
+	double operator() (int w, parameter & p);
+};
+
+/**
+ * Choose the fastest alignment plot method on this machine.
+ *
+ * All methods in AlignmentPlot::auto_methods which support the window
+ * length are timed on a sample of the input sequences. The result is
+ * stored in the profile file given by AlignmentPlot::tuning_profile
+ * (if any), and read from there for the same window length and
+ * alphabets.
+ *
+ * Options:
+ *   AlignmentPlot::auto_methods    comma-separated list of candidates
+ *                                  (default: seaweeds,blcs)
+ *   AlignmentPlot::auto_windows    number of windows of the first
+ *                                  sequence in the sample (default: 16)
+ *   AlignmentPlot::auto_length     length of the sample of the second
+ *                                  sequence (default: 50000)
+ *   AlignmentPlot::tuning_profile  profile file name (default: none)
+ */
+std::string tune_alignmentplot_method(
+	std::string const & s1,
+	std::string const & s2,
+	int w);
+
+#endif
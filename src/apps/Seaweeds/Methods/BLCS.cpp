@@ -19,6 +19,9 @@
 
 #include "datamodel/SequenceTranslation.h"
 #include "windowlocal/naive_cipr.h"
+#include "windowlocal/multi_cipr.h"
+
+#include <algorithm>
 
 #include <boost/algorithm/string.hpp>
 
@@ -28,7 +31,12 @@
 #define BLCS_BPC   8
 #endif
 
+#ifndef BLCS_LANES
+#define BLCS_LANES 4
+#endif
+
 typedef windowlocal::BPWindowLocalLCS <BLCS_BPC> Matcher;
+typedef windowlocal::MultiBPWindowLocalLCS <BLCS_BPC, BLCS_LANES> MultiMatcher;
 
 extern tbb::mutex ap_output_mutex;
 
@@ -109,6 +117,33 @@ namespace {
 				int pct_max = (int)s1.length() - w + 1;
 				int lpc = 0;
 
+				// short windows: match several s1 windows at once
+				if (w <= MultiMatcher::max_patternlength) {
+					MultiMatcher msw(w);
+					Matcher::string patterns[MultiMatcher::lanes];
+
+					for (int i = 0; i < pct_max; i += MultiMatcher::lanes) {
+						int np = std::min((int)MultiMatcher::lanes, pct_max - i);
+						for (int k = 0; k < np; ++k) {
+							patterns[k] = 
+								datamodel::make_sequence<BLCS_BPC>(
+									to_upper_copy(s1.substr(i + k, w)).c_str(), 
+									s1_chars
+								);
+						}
+						msw.set_patterns(patterns, np);
+						msw.count(s2_p, &ap, 0, i);
+
+						int tpc = i*100/pct_max;
+						if(tpc > lpc) {
+							lpc = tpc;
+							std::cerr << ".";
+						}
+					}
+					std::cerr << std::endl;
+					return;
+				}
+
 				for (int i = 0; i < pct_max; ++i) {
 					s1_p = 
 						datamodel::make_sequence<BLCS_BPC>(
@@ -77,6 +77,11 @@ namespace {
 				return true;
 			}
 
+			/** implement windowlocal::window_translator */
+			double untranslate_score(double score) {
+				return score + this->w;
+			}
+
 			/** implement AlignmentPlot_Method */
 			void run(
 				std::string const & s1, 
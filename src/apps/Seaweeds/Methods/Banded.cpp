@@ -0,0 +1,151 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include "AlignmentPlot_Method.h"
+
+// This will output all window scores to stdout
+// #define _VERBOSETEST_WINDOWOUTPUT
+
+#include "datamodel/SequenceTranslation.h"
+#include "windowlocal/banded.h"
+
+#include <algorithm>
+
+#include <boost/algorithm/string.hpp>
+
+#include <tbb/mutex.h>
+
+#ifndef BANDED_BPC
+#define BANDED_BPC   8
+#endif
+
+typedef windowlocal::BandedWindowLocalLCS <BANDED_BPC> Matcher;
+
+extern tbb::mutex ap_output_mutex;
+
+namespace {
+
+	class BandedAP;
+	struct _Ptr_Helper
+	{
+		void operator() (BandedAP * ) {}
+	};
+
+	/**
+	 * Banded window LCS alignment plots
+	 *
+	 * Window pairs are processed along the diagonals of the plot, and
+	 * only matches within Banded::band (default 8) of the diagonal of
+	 * each window pair are used.
+	 */
+	class BandedAP : public AlignmentPlot_Method {
+		public:
+			BandedAP(AlignmentPlot & ap) :
+				AlignmentPlot_Method (ap),
+				offset_x0(0), offset_x1(0)  {}
+
+			/** implement windowlocal::window_translator */
+			bool translate(windowlocal::window & w) {
+				int tmp = w.x0;
+				w.x0 = w.x1;
+				w.x1 = tmp;
+
+				w.x0+= offset_x0;
+				w.x1+= offset_x1;
+
+	#ifdef _VERBOSETEST_WINDOWOUTPUT
+				{
+					tbb::mutex::scoped_lock l (ap_output_mutex);
+
+					std::cout << w.x0 << "\t" << w.x1 << "\t" << w.score << std::endl;
+				}
+	#endif
+				return true;
+			}
+
+			/** implement AlignmentPlot_Method */
+			void run(
+				std::string const & s1,
+				std::string const & s2,
+				int offset1 = 0,
+				int offset2 = 0) {
+
+				using namespace std;
+				using namespace bsp;
+				using namespace boost;
+
+				int w = ap.get_windowlength();
+
+				if(s1.length() < w || s2.length() < w) {
+					bsp_abort("Input sequence is too short: %i < %i", min(s1.length(), s2.length()), w);
+				}
+
+				int band = 8;
+				global_options.get("Banded::band", band, band);
+				if (band < 0 || band > Matcher::max_band) {
+					bsp_abort("Band width must be between 0 and %i", Matcher::max_band);
+				}
+
+				offset_x0 = offset1;
+				offset_x1 = offset2;
+
+				string s1_chars = "ACGTN_";
+				string s2_chars = "ACGT_N";
+
+				global_options.get("Seaweeds::s1_chars", s1_chars, s1_chars);
+				global_options.get("Seaweeds::s2_chars", s2_chars, s2_chars);
+
+				Matcher::string s1_p =
+					datamodel::make_sequence<BANDED_BPC>(
+						to_upper_copy (s1).c_str(),
+						s1_chars );
+				Matcher::string s2_p =
+					datamodel::make_sequence<BANDED_BPC>(
+						to_upper_copy (s2).c_str(),
+						s2_chars );
+
+				Matcher bm(w, band);
+				ap.set_translator(boost::shared_ptr<windowlocal::window_translator>(
+					this, _Ptr_Helper()));
+
+				// diagonal d pairs window i of s1 with window i + d of s2
+				int d0 = - ((int)s1.length() - w);
+				int d1 = (int)s2.length() - w;
+				int pct_max = d1 - d0 + 1;
+				int lpc = 0;
+
+				for (int d = d0; d <= d1; ++d) {
+					int x0 = max(0, -d);
+					int y0 = max(0, d);
+					bm.count(s1_p.substr(x0, s1_p.size() - x0),
+						s2_p.substr(y0, s2_p.size() - y0), &ap, x0, y0);
+
+					int tpc = (d - d0)*100/pct_max;
+					if(tpc > lpc) {
+						lpc = tpc;
+						std::cerr << ".";
+					}
+				}
+				std::cerr << std::endl;
+			}
+
+		private:
+
+			/** alignment plot offsets */
+			int offset_x0;
+			int offset_x1;
+	};
+
+	static struct _init {
+		_init() {
+			utilities::init_xasmlib();
+			AlignmentPlot_Method::add_method<
+				AlignmentPlot_Method_Generic_Factory< BandedAP >
+			> ("blcs_banded");
+		}
+	} init;
+};
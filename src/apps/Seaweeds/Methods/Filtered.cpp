@@ -0,0 +1,194 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include "AlignmentPlot_Method.h"
+
+// This will output all window scores to stdout
+// #define _VERBOSETEST_WINDOWOUTPUT
+
+#include "datamodel/SequenceTranslation.h"
+#include "windowlocal/naive_cipr.h"
+#include "windowlocal/seaweeds.h"
+#include "windowlocal/kmer_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <boost/algorithm/string.hpp>
+
+#include <tbb/mutex.h>
+
+#ifndef FILTERED_BPC
+#define FILTERED_BPC   8
+#endif
+
+extern tbb::mutex ap_output_mutex;
+
+namespace {
+
+	struct _Ptr_Helper
+	{
+		void operator() (windowlocal::window_translator * ) {}
+	};
+
+	/**
+	 * k-mer filtered alignment plots
+	 *
+	 * A q-gram filter finds the bands of s2 which can contain windows
+	 * with LCS at least Filtered::threshold * w for each s1 window.
+	 * The exact matcher is only run inside these bands, so the
+	 * score histogram and profiles only contain the windows in them.
+	 *
+	 * Options:
+	 *   Filtered::threshold  minimum LCS relative to the window length
+	 *                        (default 0.9)
+	 *   Filtered::k          k-mer length, 0 chooses it from the
+	 *                        threshold and the composition of s2
+	 *                        (default 0)
+	 */
+	template <class _matcher, int _max_w>
+	class FilteredAP : public AlignmentPlot_Method {
+		public:
+			FilteredAP(AlignmentPlot & ap) :
+				AlignmentPlot_Method (ap),
+				offset_x0(0), offset_x1(0)  {}
+
+			/** implement windowlocal::window_translator */
+			bool translate(windowlocal::window & w) {
+				int tmp = w.x0;
+				w.x0 = w.x1;
+				w.x1 = tmp;
+
+				w.x0+= offset_x0;
+				w.x1+= offset_x1;
+
+	#ifdef _VERBOSETEST_WINDOWOUTPUT
+				{
+					tbb::mutex::scoped_lock l (ap_output_mutex);
+
+					std::cout << w.x0 << "\t" << w.x1 << "\t" << w.score << std::endl;
+				}
+	#endif
+				return true;
+			}
+
+			/** implement AlignmentPlot_Method */
+			int get_max_windowlength() {
+				return (int)_max_w;
+			}
+
+			/** implement AlignmentPlot_Method */
+			void run(
+				std::string const & s1,
+				std::string const & s2,
+				int offset1 = 0,
+				int offset2 = 0) {
+
+				using namespace std;
+				using namespace bsp;
+				using namespace boost;
+
+				int w = ap.get_windowlength();
+
+				if(s1.length() < w) {
+					bsp_abort("Input sequence is too short: %i < %i", s1.length(), w);
+				}
+
+				if (w > _max_w) {
+					bsp_abort("Maximum window length exceeded: %i > %i", w, _max_w);
+				}
+
+				offset_x0 = offset1;
+				offset_x1 = offset2;
+
+				string s1_chars = "ACGTN_";
+				string s2_chars = "ACGT_N";
+
+				global_options.get("Seaweeds::s1_chars", s1_chars, s1_chars);
+				global_options.get("Seaweeds::s2_chars", s2_chars, s2_chars);
+
+				double threshold = 0.9;
+				int k = 0;
+				global_options.get("Filtered::threshold", threshold, threshold);
+				global_options.get("Filtered::k", k, k);
+
+				typename _matcher::string s1_p =
+					datamodel::make_sequence<FILTERED_BPC>(
+						to_upper_copy (s1).c_str(),
+						s1_chars );
+				typename _matcher::string s2_p =
+					datamodel::make_sequence<FILTERED_BPC>(
+						to_upper_copy (s2).c_str(),
+						s2_chars );
+
+				_matcher sw(w, s1_p.substr(0, w));
+				ap.set_translator(boost::shared_ptr<windowlocal::window_translator>(
+					this, _Ptr_Helper()));
+
+				int min_lcs = (int)ceil(threshold * w);
+				windowlocal::KmerFilter<FILTERED_BPC> filter(s2_p, w, min_lcs, k);
+				if (!filter.enabled()) {
+					std::cerr << "Filtered::threshold is too low for k = " << filter.get_k()
+						<< ", computing all windows." << std::endl;
+				}
+
+				int pct_max = (int)s1.length() - w + 1;
+				int lpc = 0;
+
+				std::vector< std::vector< windowlocal::KmerFilter<FILTERED_BPC>::range > > ranges;
+				for (int i0 = 0; i0 < pct_max; i0 += w) {
+					int count = std::min(w, pct_max - i0);
+					if (filter.enabled()) {
+						filter.candidates(s1_p, i0, count, ranges);
+					} else {
+						ranges.assign(count, std::vector< windowlocal::KmerFilter<FILTERED_BPC>::range > (1, 
+							windowlocal::KmerFilter<FILTERED_BPC>::range(0, (int)s2_p.size() - w)));
+					}
+
+					for (int i = i0; i < i0 + count; ++i) {
+						std::vector< windowlocal::KmerFilter<FILTERED_BPC>::range > const & r (ranges[i - i0]);
+						if (r.empty()) {
+							continue;
+						}
+						sw.set_pattern(s1_p.substr(i, w));
+						for (size_t j = 0; j < r.size(); ++j) {
+							sw.count(s2_p.substr(r[j].first, r[j].second - r[j].first + w),
+								&ap, r[j].first, i);
+						}
+					}
+
+					int tpc = i0*100/pct_max;
+					if(tpc > lpc) {
+						lpc = tpc;
+						std::cerr << ".";
+					}
+				}
+				std::cerr << std::endl;
+			}
+
+		private:
+
+			/** alignment plot offsets */
+			int offset_x0;
+			int offset_x1;
+	};
+
+	typedef windowlocal::BPWindowLocalLCS<FILTERED_BPC> BLCSMatcher;
+	typedef windowlocal::SeaweedWindowLocalLCS<FILTERED_BPC, FILTERED_BPC> SeaweedMatcher;
+
+	static struct _init {
+		_init() {
+			utilities::init_xasmlib();
+			AlignmentPlot_Method::add_method<
+				AlignmentPlot_Method_Generic_Factory< FilteredAP< BLCSMatcher, 0x7fffffff > >
+			> ("blcs_filtered");
+			AlignmentPlot_Method::add_method<
+				AlignmentPlot_Method_Generic_Factory< FilteredAP< SeaweedMatcher, SeaweedMatcher::max_windowlength > >
+			> ("seaweeds_filtered");
+		}
+	} init;
+};
@@ -85,6 +85,16 @@ class SeaweedNW : public AlignmentPlot_Method {
 			return true;
 		}
 
+		/** implement windowlocal::window_translator */
+		double untranslate_score(double score) {
+			return score + this->w;
+		}
+
+		/** implement AlignmentPlot_Method */
+		int get_max_windowlength() {
+			return (int)MAX_W;
+		}
+
 		/** implement AlignmentPlot_Method */
 		void run(
 			std::string const & s1, 
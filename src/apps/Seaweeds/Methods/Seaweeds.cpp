@@ -19,6 +19,7 @@
 
 #include "datamodel/SequenceTranslation.h"
 #include "windowlocal/seaweeds.h"
+#include "windowlocal/sliding_seaweeds.h"
 
 #include <boost/algorithm/string.hpp>
 
@@ -34,18 +35,24 @@
 #define MAX_W 		(((static_cast<UINT64>(1)) << (SEAWEED_BPC)) - 1)
 
 typedef windowlocal::SeaweedWindowLocalLCS<SEAWEED_BPC, SEAWEED_BPC> Seaweeds;
+typedef windowlocal::SlidingSeaweedWindowLocalLCS<SEAWEED_BPC> SlidingSeaweeds;
 
 extern tbb::mutex ap_output_mutex;
 
 namespace {
 
-	class SeaweedsAP;
 	struct _Ptr_Helper
 	{
-		void operator() (SeaweedsAP * ) {}
+		void operator() (windowlocal::window_translator * ) {}
 	};
 
-	/** translate the scores for seaweed NW emulation */
+	/** 
+	 * translate the scores for seaweed NW emulation 
+	 * 
+	 * _matcher is run for every window of s1 on all of s2, windows
+	 * up to _max_w characters are supported.
+	 */
+	template <class _matcher, int _max_w>
 	class SeaweedsAP : public AlignmentPlot_Method {
 		public:
 			SeaweedsAP(AlignmentPlot & ap) : 
@@ -71,6 +78,11 @@ namespace {
 				return true;
 			}
 
+			/** implement AlignmentPlot_Method */
+			int get_max_windowlength() {
+				return (int)_max_w;
+			}
+
 			/** implement AlignmentPlot_Method */
 			void run(
 				std::string const & s1, 
@@ -88,8 +100,8 @@ namespace {
 					bsp_abort("Input sequence is too short: %i < %i", s1.length(), w);
 				}
 
-				if (w > MAX_W) {
-					bsp_abort("Maximum window length exceeded: %i > %i", w, MAX_W);				
+				if (w > _max_w) {
+					bsp_abort("Maximum window length exceeded: %i > %i", w, _max_w);				
 				}
 
 				offset_x0 = offset1;
@@ -101,17 +113,17 @@ namespace {
 				global_options.get("Seaweeds::s1_chars", s1_chars, s1_chars);
 				global_options.get("Seaweeds::s2_chars", s2_chars, s2_chars);
 
-				Seaweeds::string s1_p = 
+				typename _matcher::string s1_p = 
 					datamodel::make_sequence<SEAWEED_BPC>(
 						to_upper_copy(s1.substr(0, w)).c_str(), 
 						s1_chars
 					);
-				Seaweeds::string s2_p = 
+				typename _matcher::string s2_p = 
 					datamodel::make_sequence<SEAWEED_BPC>(
 						to_upper_copy (s2).c_str(), 
 						s2_chars );
 
-				Seaweeds sw(w, s1_p, 1);
+				_matcher sw(w, s1_p, 1);
 				ap.set_translator(boost::shared_ptr<windowlocal::window_translator>(
 					this, _Ptr_Helper()));
 
@@ -147,8 +159,11 @@ namespace {
 		_init() {
 			utilities::init_xasmlib();
 			AlignmentPlot_Method::add_method<
-				AlignmentPlot_Method_Generic_Factory< SeaweedsAP > 
+				AlignmentPlot_Method_Generic_Factory< SeaweedsAP< Seaweeds, MAX_W > > 
 			> ("seaweeds");
+			AlignmentPlot_Method::add_method<
+				AlignmentPlot_Method_Generic_Factory< SeaweedsAP< SlidingSeaweeds, SlidingSeaweeds::max_windowlength > > 
+			> ("seaweeds_sliding");
 		}
 	} init;	
 };
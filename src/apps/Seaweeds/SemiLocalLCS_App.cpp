@@ -0,0 +1,103 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <fstream>
+
+#include <boost/algorithm/string.hpp>
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include "SemiLocalLCS_App.h"
+#include "SemiLocalLCS_Parallel.h"
+
+#include "../global_options.h"
+#include "datamodel/TextIO.h"
+#include "datamodel/SequenceTranslation.h"
+
+/** 
+ * 32 bit seaweed distances, the permutation for each block must be 
+ * complete 
+ */
+typedef seaweeds::ScoreMatrix< 
+	seaweeds::ImplicitStorage< seaweeds::Seaweeds<32, 8> > 
+> slcs_scorematrix;
+
+typedef SemiLocalLCS_Parallel<slcs_scorematrix> SemiLocalLCS_Context;
+
+namespace {
+	/** translate a sequence into the character codes used by the seaweed algorithm */
+	std::string translate(std::string const & s, std::string const & chars) {
+		using namespace boost;
+		slcs_scorematrix::string t = 
+			datamodel::make_sequence<8>(to_upper_copy(s).c_str(), chars);
+		std::string result (t.size(), 0);
+		for (size_t j = 0; j < t.size(); ++j) {
+			result[j] = (char)t.get(j);
+		}
+		return result;
+	}
+};
+
+void SemiLocalLCS_App::run( boost::program_options::variables_map & vm ) {
+	using namespace std;
+	int    processors = vm["processors"].as<int>();
+
+	string first_file  = vm["first-sequence"].as<string>();
+	string second_file = vm["second-sequence"].as<string>();
+	string output      = vm["output-file"].as<string>();
+
+	/* pid == 0? read input! */
+	string seq1, seq2;
+	if(bsp_pid() == 0) {
+		std::ifstream ff(first_file.c_str());
+		seq1 = TextIO::read_multiline_string(ff);
+		std::ifstream sf(second_file.c_str());
+		seq2 = TextIO::read_multiline_string(sf);
+		seq1 = TextIO::trim(seq1);
+		seq2 = TextIO::trim(seq2);
+	}
+
+	/* and distribute */ 
+	bsp::bsp_broadcast(0, seq1);
+	bsp::bsp_broadcast(0, seq2);
+
+	if (seq1.length() == 0 || seq2.length() == 0) {
+		bsp_abort ("One or more of the inputs is empty. l1 = %i, l2 = %i", 
+			seq1.length(), seq2.length());
+	}
+
+	string s1_chars = "ACGTN_";
+	string s2_chars = "ACGT_N";
+	bsp::global_options.get("Seaweeds::s1_chars", s1_chars, s1_chars);
+	bsp::global_options.get("Seaweeds::s2_chars", s2_chars, s2_chars);
+
+	/** every processor needs at least one character of the second sequence */
+	if(processors > (int)seq2.length()) {
+		processors = (int)seq2.length();
+	}
+
+	cout << "Processors: " << processors << " S1: " 
+		<< seq1.length() << " S2: " << seq2.length() << endl;
+
+	bsp::Runner<SemiLocalLCS_Context> runner (processors);
+	runner.set_inputs(translate(seq1, s1_chars), translate(seq2, s2_chars));
+	runner.run();
+
+	if(bsp_pid() == 0 && SemiLocalLCS_Context::result_ready()) {
+		int m = (int)seq1.length();
+		int n = (int)seq2.length();
+		slcs_scorematrix sm (m, n, SemiLocalLCS_Context::get_result());
+		cout << "LCS: " << sm.score(0, n) << endl;
+
+		cout << "Writing output: " << output << endl;
+		std::ofstream out(output.c_str());
+		out << m << "\t" << n << endl;
+		for (int j = 0; j < m + n; ++j) {
+			out << SemiLocalLCS_Context::get_result()[j] << endl;
+		}
+	}
+}
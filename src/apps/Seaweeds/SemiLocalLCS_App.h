@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SemiLocalLCS_App_H__
+#define __SemiLocalLCS_App_H__
+
+#include "../App.h"
+
+/**
+ * Semi-local LCS app: computes the seaweed permutation for two 
+ * sequences in parallel (see SemiLocalLCS_Parallel).
+ */
+class SemiLocalLCS_App : public App  {
+public:
+	void add_opts( boost::program_options::options_description & all_opts ) {
+		using namespace std;
+		namespace po = boost::program_options;
+
+		po::options_description hidden("Input/Output Options");
+		hidden.add_options()
+			(	"first-sequence",
+				po::value< string >() -> default_value("first.txt"),
+				"Name of first input sequence")
+			(	"second-sequence",
+				po::value< string >()-> default_value("second.txt"),
+				"Name of second input sequence (this one is split between processors)")
+			(	"output-file",
+				po::value< string >()-> default_value("result.txt"),
+				"output file name")
+		;
+
+		all_opts.add(hidden);
+	}
+
+	void run( boost::program_options::variables_map & vm );
+};
+
+#endif /** __SemiLocalLCS_App_H__ */
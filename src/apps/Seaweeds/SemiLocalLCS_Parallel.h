@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SemiLocalLCS_Parallel_H__
+#define __SemiLocalLCS_Parallel_H__
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/shared_ptr.hpp>
+
+#include "bsp_cpp/bsp_cpp.h"
+
+#include "seaweeds/ScoreMatrix.h"
+
+/**
+ * \brief Distributed semi-local LCS for one pair of strings.
+ *
+ * Every processor computes the seaweed permutation for x against its
+ * block of y. The blocks are merged in a binary reduction tree using
+ * seaweed matrix multiplication, each merge communicates one
+ * permutation of size O(m+n). After run(), processor 0 has the
+ * seaweed permutation for x vs. y.
+ *
+ * The seaweed permutation must be complete for all blocks, so omega
+ * must be large enough to hold distances up to m + |y|.
+ *
+ * This is run by the SemiLocalLCS app (SemiLocalLCS_App).
+ */
+template <class _scorematrix>
+class SemiLocalLCS_Parallel : public bsp::Context {
+public:
+	typedef _scorematrix scorematrix;
+	typedef typename scorematrix::string string;
+	typedef typename scorematrix::archive archive;
+
+	SemiLocalLCS_Parallel() {
+		CONTEXT_SHARED_INIT(x, std::string);
+		CONTEXT_SHARED_INIT(y, std::string);
+		i_have_the_result = false;
+	}
+
+	/** set the input strings, these must be translated already */
+	void set_inputs(std::string const & _x, std::string const & _y) {
+		x = _x;
+		y = _y;
+	}
+
+	static bool result_ready() {
+		return i_have_the_result;
+	}
+
+	/** the seaweed permutation for x vs. y */
+	static archive & get_result() {
+		ASSERT(i_have_the_result);
+		return result;
+	}
+
+	void run() {
+		using namespace std;
+		BSP_SCOPE(SemiLocalLCS_Parallel);
+		BSP_BEGIN();
+
+		P = bsp_nprocs();
+		p = bsp_pid();
+		m = (int)x.size();
+		N = (int)y.size();
+		ASSERT(N > 0);
+
+		perm.resize(m + N);
+		incoming.resize(m + N);
+
+		my_y0 = block_start(p);
+		my_y1 = block_start(p + 1);
+
+		// with fewer characters in y than processors, the last 
+		// processors get empty blocks and don't take part
+		if (my_y1 > my_y0) {
+			my_sm = boost::shared_ptr<scorematrix>(new scorematrix(m, my_y1 - my_y0));
+			my_sm->semilocallcs(string(x), string(y.substr(my_y0, my_y1 - my_y0)));
+			std::copy(my_sm->get_archive().begin(), my_sm->get_archive().begin() + m + my_y1 - my_y0, perm.begin());
+		}
+
+		bsp_push_reg(&incoming[0], (m + N) * sizeof(int));
+		BSP_SYNC();
+
+		// processors p with p % (2*stride) == 0 collect the blocks of
+		// p, ..., p+2*stride-1
+		for (stride = 1; stride < P; stride *= 2) {
+			if (p % (2*stride) == stride && my_y1 > my_y0) {
+				bsp_hpput(p - stride, &perm[0], &incoming[0], 0,
+					(m + my_y1 - my_y0) * sizeof(int));
+			}
+			BSP_SYNC();
+			// empty blocks are at the end, so a processor which 
+			// receives a non-empty block has a non-empty block itself
+			if (p % (2*stride) == 0 && p + stride < P 
+			 && block_start(p + 2*stride) > block_start(p + stride)) {
+				int n2 = block_start(p + 2*stride) - block_start(p + stride);
+				scorematrix rhs(m, n2, incoming);
+				if (!my_sm->concatenate_y(rhs)) {
+					bsp_abort("Seaweed permutation is incomplete, omega is too small for m = %i, n = %i", m, N);
+				}
+				my_y1 = block_start(p + 2*stride);
+				std::copy(my_sm->get_archive().begin(), my_sm->get_archive().begin() + m + my_y1 - my_y0, perm.begin());
+			}
+			// bsp_hpput is unbuffered, the next block must not arrive
+			// before this one has been merged
+			BSP_SYNC();
+		}
+
+		bsp_pop_reg(&incoming[0]);
+
+		if (p == 0) {
+			i_have_the_result = true;
+			result.resize(m + N);
+			std::copy(perm.begin(), perm.begin() + m + N, result.begin());
+		}
+
+		BSP_END();
+	}
+
+protected:
+	/** 
+	 * first character of y for processor q. The first N % P 
+	 * processors get one character more than the others.
+	 */
+	int block_start(int q) {
+		q = std::min(q, P);
+		return q * (N / P) + std::min(q, N % P);
+	}
+
+	/** Context variables */
+	std::string x;
+	std::string y;
+	int P, p, m, N, my_y0, my_y1, stride;
+	std::vector<int> perm;
+	std::vector<int> incoming;
+	boost::shared_ptr<scorematrix> my_sm;
+
+	/** Result output */
+	static bool i_have_the_result;
+	static archive result;
+};
+
+template <class _scorematrix>
+bool SemiLocalLCS_Parallel<_scorematrix>::i_have_the_result;
+
+template <class _scorematrix>
+typename SemiLocalLCS_Parallel<_scorematrix>::archive SemiLocalLCS_Parallel<_scorematrix>::result;
+
+#endif // __SemiLocalLCS_Parallel_H__
@@ -95,10 +95,13 @@ namespace datamodel {
 				other_buffer.resize(wanted_len);
 				read_len = input->read_sequence(other_buffer);
 
-				// can copy the first part, target is bigger than overlap_buffer.
+				// can copy the first part. overlap_buffer may have more
+				// words than target, since extract_substring leaves room
+				// for shifting.
 				memcpy(	target.datavector().exact_data(0), 
 						overlap_buffer.datavector().exact_data(0), 
-						overlap_buffer.datavector().exact_size() << 3
+						std::min(overlap_buffer.datavector().exact_size(), 
+							target.datavector().exact_size()) << 3
 				);
 				// The memcpy above might have messed this up.
 				target.fixending();
@@ -117,7 +120,10 @@ namespace datamodel {
 
 				if (read_len < wanted_len) {
 					if (remaining_overlap < 0) {
-						remaining_overlap = (long)(window_overlap - (wanted_len - read_len));
+						using namespace std;
+						// when we run out by more than the overlap, there is
+						// nothing left for the next window
+						remaining_overlap = max ((long int)0l, (long int)window_overlap - (long int)(wanted_len - read_len));
 						read_len += window_overlap;
 					} else {
 						using namespace std;
@@ -136,6 +142,13 @@ namespace datamodel {
 				if (read_len < window_overlap) {
 					throw std::runtime_error("Input sequence is too short.");
 				}
+				if (read_len < length) {
+					// the next window only contains what is left of this one
+					remaining_overlap = (long int)read_len - (long int)wanted_len;
+					remaining_overlap = std::max ((long int)0l, remaining_overlap);
+				} else {
+					remaining_overlap = -1;
+				}
 			}
 			current_pos+= wanted_len;
 			// Get overlap buffer for next step
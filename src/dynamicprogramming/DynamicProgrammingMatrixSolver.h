@@ -12,6 +12,22 @@ namespace dynamic_programming {
 
 #pragma optimize("g",on)
 
+	/*!
+	 * \brief operator properties for DynamicProgrammingMatrixSolver
+	 *
+	 * Specialise this and set antidiagonal = 1 for operators which are
+	 * cheap and branch-free enough that evaluating all cells of an
+	 * anti-diagonal in one loop pays off. The cells on an anti-diagonal
+	 * do not depend on each other, so the compiler can vectorise this
+	 * loop when operator_t::operator() is inlined.
+	 */
+	template <class operator_t>
+	struct dp_operator_traits {
+		enum {
+			antidiagonal = 0,
+		};
+	};
+
 	/*!
 	 * \class dp_matrix_rowmajor_solver
 	 *
@@ -25,6 +41,7 @@ namespace dynamic_programming {
 	 *        operator() (int) returning some type that will be passed to
 	 *                         operator_t :: operator ()
 	 *        size_t size() returning the size of the input
+	 *        value_type (anti-diagonal evaluation copies the inputs)
 	 *   dp_element_t -- type of dp matrix elements 
 	 *   operator_t -- dp operator
 	 *        dp_element_t operator() (size_t i, size_t j,
@@ -34,6 +51,9 @@ namespace dynamic_programming {
 	 *                    dp_element_t const & top_left,
 	 *                    dp_element_t const & top,
 	 *        )
+	 *
+	 * The matrix is evaluated row by row, or by anti-diagonals if
+	 * dp_operator_traits<operator_t>::antidiagonal is set.
 	 * 
 	 * \author Peter Krusche
 	 * \date October 2010
@@ -68,9 +88,111 @@ namespace dynamic_programming {
 
 	public:
 		dp_element_t operator() (input_t left_input, input_t top_input) {
+			if (dp_operator_traits<operator_t>::antidiagonal) {
+				return solve_antidiagonal(left_input, top_input);
+			} else {
+				return solve_rowmajor(left_input, top_input);
+			}
+		}
+
+		/*!
+		 * \brief evaluate the matrix row by row
+		 */
+		dp_element_t solve_rowmajor (input_t left_input, input_t top_input) {
+			size_t m = left_input.size();
+			size_t n = top_input.size();
+
+			init(m, n);
+			
+			register dp_element_t last = (*prev_top_row)[n];
+
+			for (register size_t i = 1; i <= m; ++i) {
+				last = (*cur_left_col)[i];
+				(*cur_top_row)[0] = last;
+				for (register size_t j = 1; j <= n; ++j) {
+					last = op(i, j, left_input[i-1], top_input[j-1], last, (*prev_top_row)[j-1], (*prev_top_row)[j]);
+					(*cur_top_row)[j] = last;
+				}
+				swap(cur_top_row, prev_top_row);
+				(*cur_left_col)[i] = last;
+			}
+			return last;
+		}
+
+		/*!
+		 * \brief evaluate the matrix by anti-diagonals
+		 *
+		 * Cell (i, j) is on anti-diagonal d = i + j and is stored at
+		 * index i in the buffer for d. Its left and top neighbours are
+		 * at i and i-1 on d-1, the top-left neighbour is at i-1 on d-2.
+		 * The top input is reversed so that both inputs are read
+		 * in increasing order along an anti-diagonal.
+		 *
+		 * Gives the same results as solve_rowmajor.
+		 */
+		dp_element_t solve_antidiagonal (input_t left_input, input_t top_input) {
 			size_t m = left_input.size();
 			size_t n = top_input.size();
 
+			init(m, n);
+
+			left_chars.resize(m);
+			for (size_t i = 0; i < m; ++i) {
+				left_chars[i] = left_input[i];
+			}
+			top_chars.resize(n);
+			for (size_t j = 0; j < n; ++j) {
+				top_chars[j] = top_input[n-1-j];
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				diagonals[k].resize(m+1);
+			}
+			dp_element_t * d2 = &diagonals[0][0];
+			dp_element_t * d1 = &diagonals[1][0];
+			dp_element_t * d0 = &diagonals[2][0];
+
+			std::vector<dp_element_t> & top = *prev_top_row;
+			std::vector<dp_element_t> & left = *cur_left_col;
+
+			for (size_t d = 0; d <= m + n; ++d) {
+				// boundary cells
+				if (d <= n) {
+					d0[0] = top[d];
+				}
+				if (d >= 1 && d <= m) {
+					d0[d] = left[d];
+				}
+
+				size_t i0 = d > n ? d - n : 1;
+				size_t i1 = d > m ? m : d - 1;
+				if (d >= 2 && i0 <= i1) {
+					const typename input_t::value_type * lc = &left_chars[i0-1];
+					const typename input_t::value_type * tc = &top_chars[n+i0-d];
+					size_t cells = i1 - i0 + 1;
+					for (size_t k = 0; k < cells; ++k) {
+						size_t i = i0 + k;
+						d0[i] = op(i, d-i, lc[k], tc[k], d1[i], d2[i-1], d1[i-1]);
+					}
+					if (d > n) {
+						// right column
+						left[d-n] = d0[d-n];
+					}
+				}
+
+				dp_element_t * t = d2;
+				d2 = d1;
+				d1 = d0;
+				d0 = t;
+			}
+			return d1[m];
+		}
+
+	private:
+		/*!
+		 * \brief set up the boundary row and column
+		 */
+		void init(size_t m, size_t n) {
 			if(left_dp_column.size() < m+1) {
 				left_dp_column.resize(m+1);
 			}
@@ -78,8 +200,6 @@ namespace dynamic_programming {
 			if(top_dp_row.size() < n+1) {
 				top_dp_row.resize(n+1);
 			}
-			
-			register dp_element_t last;
 
 			if(tmp_dp.size() < top_dp_row.size()) {
 				tmp_dp.resize(top_dp_row.size());
@@ -88,24 +208,20 @@ namespace dynamic_programming {
 			cur_top_row = &tmp_dp;
 			cur_left_col = &left_dp_column;
 
-			for (register size_t i = 0; i <= cur_left_col->size(); ++i) {
+			for (register size_t i = 0; i < cur_left_col->size(); ++i) {
 				(*cur_left_col)[i] = op.init_l();
 			}		
-			for (register size_t i = 0; i <= prev_top_row->size(); ++i) {
+			for (register size_t i = 0; i < prev_top_row->size(); ++i) {
 				(*prev_top_row)[i] = op.init_t();
 			}		
-
-			for (register size_t i = 1; i <= m; ++i) {
-				last = (*cur_left_col)[i];
-				for (register size_t j = 1; j <= n; ++j) {
-					last = op(i, j, left_input[i-1], top_input[j-1], last, (*prev_top_row)[j-1], (*prev_top_row)[j]);
-					(*cur_top_row)[j] = last;
-				}
-				swap(cur_top_row, prev_top_row);
-				(*cur_left_col)[i] = last;
-			}
-			return last;
 		}
+
+		/*!
+		 * input copies and anti-diagonal buffers for solve_antidiagonal
+		 */
+		std::vector<typename input_t::value_type> left_chars;
+		std::vector<typename input_t::value_type> top_chars;
+		std::vector<dp_element_t> diagonals[3];
 	};
 };
 
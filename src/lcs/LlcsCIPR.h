@@ -32,6 +32,18 @@ namespace lcs {
 		return o;
 	}
 
+	/** count the bits set in a 64 bit word */
+	inline size_t popcount64(UINT64 x) {
+#ifdef __GNUC__
+		return (size_t)__builtin_popcountll(x);
+#else
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+		return (size_t)((x * 0x0101010101010101ULL) >> 56);
+#endif
+	}
+
 template <size_t _bpc>
 class LlcsCIPR {
 public:
@@ -74,6 +86,12 @@ public:
 
 		/* extract to local variables */
 		size_t ylen= _y.size();
+
+		/* short patterns without carry inputs or outputs */
+		if (_r == NULL && _c == NULL && xlen <= 4*64) {
+			return cipr_short(xlen, gM, _y, 0, ylen);
+		}
+
 		size_t lbits= 8 * sizeof(UINT64);
 		size_t rlen= xlen % lbits;
 		size_t lxlen= xlen / lbits;
@@ -138,6 +156,100 @@ public:
 		return count;
 	}
 
+	/*
+	* Compute the LCS length of x and the substring _y[y0, y0 + ylen)
+	* in place, using a row bit string which is supplied by the caller.
+	* 
+	* _r must have xlen bits. It is reset before the computation, so 
+	* it can be re-used for many calls without reallocating. For 
+	* patterns of up to 256 characters, _r is not used.
+	* */
+	size_t operator()(
+		size_t xlen,
+		utilities::CharMapping<_bpc, 1, false> & gM,
+		utilities::IntegerVector<_bpc> const & _y,
+		size_t y0, 
+		size_t ylen,
+		utilities::BitString & _r
+		) {
+		using namespace utilities;
+		ASSERT(_r.size() == xlen);
+		ASSERT(y0 + ylen <= _y.size());
+
+		if (xlen <= 4*64) {
+			return cipr_short(xlen, gM, _y, y0, ylen);
+		}
+
+		_r.one();
+		for (size_t j = y0; j < y0 + ylen; ++j) {
+			_r.add_cipr(gM[(size_t)_y.get(j)], 0);
+		}
+		return _r.count_zeros();
+	}
+
+private:
+	/**
+	 * CIPR for patterns of up to 256 characters: dispatch to a kernel 
+	 * for the number of machine words needed.
+	 */
+	static size_t cipr_short(
+		size_t xlen,
+		utilities::CharMapping<_bpc, 1, false> & gM,
+		utilities::IntegerVector<_bpc> const & _y,
+		size_t y0, 
+		size_t ylen
+	) {
+		switch ((xlen + 63) >> 6) {
+			case 0:
+				return 0;
+			case 1:
+				return cipr_fixed<1>(gM, _y, y0, ylen);
+			case 2:
+				return cipr_fixed<2>(gM, _y, y0, ylen);
+			case 3:
+				return cipr_fixed<3>(gM, _y, y0, ylen);
+			default:
+				return cipr_fixed<4>(gM, _y, y0, ylen);
+		}
+	}
+
+	/**
+	 * CIPR kernel with the row kept in _words machine words.
+	 * 
+	 * The bits after the end of the pattern start as ones and have 
+	 * no matches, so (L + (L&M)) | (L&~M) leaves them set. The LCS 
+	 * length is the number of zero bits in the row.
+	 */
+	template <int _words>
+	static size_t cipr_fixed(
+		utilities::CharMapping<_bpc, 1, false> & gM,
+		utilities::IntegerVector<_bpc> const & _y,
+		size_t y0, 
+		size_t ylen
+	) {
+		UINT64 r[_words];
+		for (int k = 0; k < _words; ++k) {
+			r[k] = (UINT64)-1;
+		}
+		for (size_t j = y0; j < y0 + ylen; ++j) {
+			const UINT64 * m = gM[(size_t)_y.get(j)].datavector().data;
+			UINT64 carry = 0;
+			for (int k = 0; k < _words; ++k) {
+				UINT64 l = r[k];
+				UINT64 s = l + (l & m[k]);
+				UINT64 c = s < l ? 1 : 0;
+				s += carry;
+				carry = c | (s < carry ? 1 : 0);
+				r[k] = s | (l & ~m[k]);
+			}
+		}
+		size_t ones = 0;
+		for (int k = 0; k < _words; ++k) {
+			ones += popcount64(r[k]);
+		}
+		return _words*64 - ones;
+	}
+
 };
 
 };
@@ -527,11 +527,34 @@ namespace pssms {
 
 		virtual double score (string const & sequence, int offset = 0) = 0;
 		virtual size_t min_length() = 0;
+
+		/**
+		 * Score all offsets in [from, to), out receives to - from values.
+		 * Score functions can override this to avoid one virtual call per offset.
+		 */
+		virtual void score_all (string const & sequence, int from, int to, double * out) {
+			for (int k = from; k < to; ++k) {
+				*out++ = score(sequence, k);
+			}
+		}
+
+		/**
+		 * Score functions which add up one table entry per position can
+		 * return true here to allow exact score distributions.
+		 *
+		 * The table has alphabet + 1 entries per position, the last one is
+		 * used for unknown characters. Scores are sums of table entries
+		 * minus offset, or zero if this is negative.
+		 */
+		virtual bool get_additive_table (std::vector<double> & table, size_t & alphabet, double & offset) {
+			return false;
+		}
 	};
 
 	// distance functors are in here.	#include "Pssm_distance.inl"
 	#include "Pssm_distance.inl"
 	#include "Pssm_multiplicative.inl"
+	#include "Pssm_multiscan.inl"
 	#include "Pssm_profile.inl"
 
 	// naive score factory. this could probably done better.
@@ -579,34 +602,30 @@ namespace pssms {
 		}
 
 		/**
-		 * Create a score object from a PSSM.
+		 * Pseudocount type for a score type.
 		 */
-		static boost::shared_ptr< PSSM_Score <string> > create ( PSSM<alphasize> const & p, scoretype_t scoretype ) {
+		static typename PSSM<alphasize>::pseudocount_t pseudocount ( scoretype_t scoretype ) {
 			switch ( scoretype ) {
 			case MULT_NO_PC:
-				{
-					boost::shared_ptr< PSSM_Score <string> > ret (new PSSM_Multiplicative_Score < string, alphasize > (p, PSSM< alphasize > :: PSEUDOCOUNT_NONE ));
-					return ret;
-				}
+				return PSSM< alphasize > :: PSEUDOCOUNT_NONE;
 			case MULT_SQRT_PC:
-				{
-					boost::shared_ptr< PSSM_Score <string> > ret (new PSSM_Multiplicative_Score < string, alphasize > (p, PSSM< alphasize > :: PSEUDOCOUNT_SQRT ));
-					return ret;
-				}
+				return PSSM< alphasize > :: PSEUDOCOUNT_SQRT;
 			case MULT_LINEAR_PC:
-				{
-					boost::shared_ptr< PSSM_Score <string> > ret (new PSSM_Multiplicative_Score < string, alphasize > (p, PSSM< alphasize > :: PSEUDOCOUNT_LINEAR ));
-					return ret;
-				}
+				return PSSM< alphasize > :: PSEUDOCOUNT_LINEAR;
 			case MULT_BIFA_PC:
-				{
-					boost::shared_ptr< PSSM_Score <string> > ret (new PSSM_Multiplicative_Score < string, alphasize > (p, PSSM< alphasize > :: PSEUDOCOUNT_BIFA ));
-					return ret;
-				}
+				return PSSM< alphasize > :: PSEUDOCOUNT_BIFA;
 			default:
 				throw std::runtime_error("Unknown score type.");
 			};
 		}
+
+		/**
+		 * Create a score object from a PSSM.
+		 */
+		static boost::shared_ptr< PSSM_Score <string> > create ( PSSM<alphasize> const & p, scoretype_t scoretype ) {
+			boost::shared_ptr< PSSM_Score <string> > ret (new PSSM_Multiplicative_Score < string, alphasize > (p, pseudocount(scoretype) ));
+			return ret;
+		}
 	};
 
 };
@@ -253,4 +253,253 @@ typedef AllRotationsDistance <
 Opposite_Strand_DNA_Min_Hellinger_Distance;
 
 
+/**
+ * Precomputed columns of a PSSM on both strands, for computing many 
+ * distances with Fast_Both_Strands_DNA_Min_Distance.
+ *
+ * For each strand, we store sqrt(p) for the Hellinger distance, and 
+ * p, log2(p) and a mask (p > FLT_MIN) for the Kullback-Leibler 
+ * distance, for every position and for the background.
+ */
+template <size_t alphasize = 4>
+class PSSM_Distance_Columns {
+public:
+	struct strand {
+		std::vector<double> sq, pe, l, m;
+		double b_sq[alphasize], b_pe[alphasize], b_l[alphasize], b_m[alphasize];
+	};
+
+	PSSM_Distance_Columns () : length(0) {}
+
+	explicit PSSM_Distance_Columns (PSSM<alphasize> const & p) {
+		set(p);
+	}
+
+	void set (PSSM<alphasize> const & p) {
+		length = p.get_length();
+		for (int r = 0; r < 2; ++r) {
+			strand & st (r ? rev : fwd);
+			st.sq.resize(length * alphasize);
+			st.pe.resize(length * alphasize);
+			st.l.resize(length * alphasize);
+			st.m.resize(length * alphasize);
+			for (int k = 0; k < length; ++k) {
+				for (int j = 0; j < (int)alphasize; ++j) {
+					// like HellingerDistance<true>: reverse position and character
+					int pos = r ? p.reverse_pos(p.begin() + k) : p.begin() + k;
+					int c = r ? p.reverse_char(j) : j;
+					column(p(pos, c), st.sq[k*alphasize + j], st.pe[k*alphasize + j], 
+						st.l[k*alphasize + j], st.m[k*alphasize + j]);
+				}
+			}
+			for (int j = 0; j < (int)alphasize; ++j) {
+				// positions outside the PSSM give the background distribution
+				int c = r ? p.reverse_char(j) : j;
+				column(p(p.end() + 1, c), st.b_sq[j], st.b_pe[j], st.b_l[j], st.b_m[j]);
+			}
+		}
+	}
+
+	int length;
+	strand fwd, rev;
+
+private:
+	static void column (double p, double & sq, double & pe, double & l, double & m) {
+		using namespace std;
+		static const double log2 = log(2.0);
+		sq = sqrt(p);
+		if (p > FLT_MIN) {
+			pe = p;
+			l = log(p) / log2;
+			m = 1;
+		} else {
+			pe = l = m = 0;
+		}
+	}
+};
+
+/**
+ * Both_Strands_DNA_Min_Hellinger_Distance (hellinger = true) or 
+ * Both_Strands_DNA_Min_KullbackLeibler_Distance (hellinger = false) 
+ * on precomputed columns.
+ *
+ * Instead of evaluating the distance separately for every shift, the
+ * parts of the sums where only one of the PSSMs overlaps the other
+ * one's background are taken from prefix sums, and only the 
+ * overlapping columns are compared for each shift. The results are 
+ * the same as the ones of the PSSM distance functors up to rounding.
+ *
+ * Objects of this class keep buffers, so every thread needs its own.
+ */
+template <bool hellinger, size_t alphasize = 4>
+class Fast_Both_Strands_DNA_Min_Distance {
+public:
+	typedef PSSM_Distance_Columns<alphasize> columns;
+
+	double operator () (columns const & a, columns const & b) {
+		using namespace std;
+		const int LA = a.length;
+		const int LB = b.length;
+		const int nd = LA + LB - 1;
+		d1.resize(nd);
+		d2.resize(nd);
+		d3.resize(nd);
+		d4.resize(nd);
+
+		// shifts s of A relative to B, from -(LA-1) to LB-1 
+		// (index s + LA - 1). For B relative to A, this is reversed.
+		shifts (a.fwd, LA, b.fwd, LB, &d1[0]);
+		shifts (a.rev, LA, b.fwd, LB, &d2[0]);
+		if (!hellinger) {
+			shifts (b.fwd, LB, a.fwd, LA, &d3[0]);
+		}
+		shifts (b.rev, LB, a.fwd, LA, &d4[0]);
+
+		double result = DBL_MAX;
+		for (int s = 0; s < nd; ++s) {
+			// the Hellinger distance is symmetric in its arguments
+			double ab = min (d1[s], d2[s]);
+			double ba = min (hellinger ? d1[s] : d3[nd - 1 - s], d4[nd - 1 - s]);
+			result = min (result, ( ab + ba ) / 2.0);
+		}
+		return result;
+	}
+
+private:
+	typedef typename columns::strand strand;
+
+	/**
+	 * Distances of X and Y for shifts d of X relative to Y from -(LX-1) 
+	 * to LY-1, written to out[d + LX - 1].
+	 */
+	void shifts (strand const & x, int LX, strand const & y, int LY, double * out) {
+		const int A = (int)alphasize;
+		// prefix and suffix sums of X against Y's background and vice versa
+		px.resize((LX + 1) * A);
+		sx.resize((LX + 1) * A);
+		py.resize((LY + 1) * A);
+		sy.resize((LY + 1) * A);
+
+		if (hellinger) {
+			for (int k = 0; k < LX; ++k) {
+				for (int j = 0; j < A; ++j) {
+					double t = x.sq[k*A + j] - y.b_sq[j];
+					sx[k*A + j] = 0.5*t*t;
+				}
+			}
+			for (int k = 0; k < LY; ++k) {
+				for (int j = 0; j < A; ++j) {
+					double t = x.b_sq[j] - y.sq[k*A + j];
+					sy[k*A + j] = 0.5*t*t;
+				}
+			}
+			prefix_suffix (LX, px, sx);
+			prefix_suffix (LY, py, sy);
+
+			for (int d = -(LX-1); d < LY; ++d) {
+				const int lo = std::max (d, 0);
+				const int hi = std::min (d + LX - 1, LY - 1);
+				double sum[alphasize];
+				for (int j = 0; j < A; ++j) {
+					sum[j] = ( px[(lo-d)*A + j] + sx[(hi-d+1)*A + j] ) 
+					       + ( py[lo*A + j] + sy[(hi+1)*A + j] );
+				}
+				const double * xs = &x.sq[(lo-d)*A];
+				const double * ys = &y.sq[lo*A];
+				for (int i = 0; i <= hi - lo; ++i) {
+					for (int j = 0; j < A; ++j) {
+						double t = xs[i*A + j] - ys[i*A + j];
+						sum[j] += 0.5*t*t;
+					}
+				}
+				double res = 0;
+				for (int j = 0; j < A; ++j) {
+					res += sqrt (sum[j]);
+				}
+				out[d + LX - 1] = res;
+			}
+		} else {
+			// KullbackLeiblerDistance adds up the partial sums after every 
+			// position, so a term at position i is counted end - i + 1 times.
+			// We keep sums of terms and of terms times position
+			// (at index 0 and 1 for each position, positions of X are 
+			// counted from its start).
+			for (int k = 0; k < LX; ++k) {
+				double t = 0;
+				for (int j = 0; j < A; ++j) {
+					t += x.pe[k*A + j] * y.b_m[j] * (x.l[k*A + j] - y.b_l[j]);
+				}
+				sx[k*A] = t;
+				sx[k*A + 1] = k*t;
+			}
+			for (int k = 0; k < LY; ++k) {
+				double t = 0;
+				for (int j = 0; j < A; ++j) {
+					t += x.b_pe[j] * y.m[k*A + j] * (x.b_l[j] - y.l[k*A + j]);
+				}
+				sy[k*A] = t;
+				sy[k*A + 1] = k*t;
+			}
+			prefix_suffix (LX, px, sx);
+			prefix_suffix (LY, py, sy);
+
+			for (int d = -(LX-1); d < LY; ++d) {
+				const int lo = std::max (d, 0);
+				const int hi = std::min (d + LX - 1, LY - 1);
+				const int end = std::max (d + LX - 1, LY - 1);
+
+				// X outside Y, positions relative to Y are k + d
+				double x0 = px[(lo-d)*A] + sx[(hi-d+1)*A];
+				double x1 = px[(lo-d)*A + 1] + sx[(hi-d+1)*A + 1] + d * x0;
+				double s0 = x0 + py[lo*A] + sy[(hi+1)*A];
+				double s1 = x1 + py[lo*A + 1] + sy[(hi+1)*A + 1];
+
+				const double * xpe = &x.pe[(lo-d)*A];
+				const double * xl = &x.l[(lo-d)*A];
+				const double * ym = &y.m[lo*A];
+				const double * yl = &y.l[lo*A];
+				for (int i = 0; i <= hi - lo; ++i) {
+					double t = 0;
+					for (int j = 0; j < A; ++j) {
+						t += xpe[i*A + j] * ym[i*A + j] * (xl[i*A + j] - yl[i*A + j]);
+					}
+					s0 += t;
+					s1 += (lo + i) * t;
+				}
+				out[d + LX - 1] = (end + 1) * s0 - s1;
+			}
+		}
+	}
+
+	/**
+	 * Turn values v[k*A + j] (k < L) into suffix sums v[k*A + j] = sum of 
+	 * values at k..L-1, and prefix sums p[k*A + j] = sum of values at 0..k-1.
+	 */
+	static void prefix_suffix (int L, std::vector<double> & p, std::vector<double> & v) {
+		const int A = (int)alphasize;
+		for (int j = 0; j < A; ++j) {
+			p[j] = 0;
+			v[L*A + j] = 0;
+		}
+		for (int k = 0; k < L; ++k) {
+			for (int j = 0; j < A; ++j) {
+				p[(k+1)*A + j] = p[k*A + j] + v[k*A + j];
+			}
+		}
+		for (int k = L - 1; k >= 0; --k) {
+			for (int j = 0; j < A; ++j) {
+				v[k*A + j] += v[(k+1)*A + j];
+			}
+		}
+	}
+
+	std::vector<double> d1, d2, d3, d4;
+	/** prefix and suffix sums */
+	std::vector<double> px, sx, py, sy;
+};
+
+typedef Fast_Both_Strands_DNA_Min_Distance<false> Fast_Both_Strands_DNA_Min_KullbackLeibler_Distance;
+typedef Fast_Both_Strands_DNA_Min_Distance<true> Fast_Both_Strands_DNA_Min_Hellinger_Distance;
+
+
 #endif // __Pssm_distance_H__
@@ -23,6 +23,7 @@ public:
 		pssm.add_pseudocount(t);
 		min_sc = min_score();
 		n_sc = max_score() - min_sc;
+		make_table();
 	}
 
 	/**
@@ -75,35 +76,112 @@ public:
 	/**
 	 * Score PSSM on one location in a given sequence
 	 * 
-	 * @param pssm     : the matrix
 	 * @param sequence : a sequence (template class must support operator [] which returns something int)
 	 * @param offset   : where to start scoring in the sequence
 	 * 
 	 */
 	double score (string const & sequence, int offset = 0) {
-		int i = pssm.begin ();
+		const int len = (int)pssm.get_length();
+		const double * t = &table[0];
 		double sc = 0;
 		int any_matched = false;
-		for (int j = offset; j < offset + pssm.get_length(); ++j) {
-			int ch = (int)sequence[j];
+		for (int i = 0; i < len; ++i) {
+			int ch = (int)sequence[offset + i];
 			if (ch < alphasize) {
-				double psc = pssm(i, (int)sequence[j]);
-				if (psc < DBL_EPSILON) {
-					psc = DBL_EPSILON;
-				}
-				sc += log (4 * psc);
+				sc += t[ch];
 				any_matched = true;
 			}
-			++i;
+			t += alphasize + 1;
 		}
-		if (!any_matched) {
+		if (!any_matched || sc < min_sc_n) {
 			return 0;
 		}
-		if (sc < min_sc) {
-			return 0;
+		return sc - min_sc_n;
+	}
+
+	/**
+	 * Score all offsets in [from, to) of a sequence
+	 *
+	 * Gives the same values as score(sequence, k) for each offset k,
+	 * but reads every character only once and adds up table entries
+	 * position by position for all offsets.
+	 *
+	 * @param sequence : the sequence, must have at least to + min_length() - 1 characters
+	 * @param from     : first offset
+	 * @param to       : one past the last offset
+	 * @param out      : output, receives to - from scores
+	 */
+	void score_range (string const & sequence, int from, int to, double * out) {
+		const int len = (int)pssm.get_length();
+		const int count = to - from;
+		if (count <= 0) {
+			return;
 		}
-		
-		return (sc - min_sc) / n_sc;
+
+		// translate once, unknown characters are mapped to the zero column
+		chars.resize(count + len - 1);
+		for (int j = 0; j < count + len - 1; ++j) {
+			int ch = (int)sequence[from + j];
+			chars[j] = (unsigned char) (ch < alphasize ? ch : alphasize);
+		}
+
+		// blocks of offsets are summed up in the cache
+		const int block = 512;
+		for (int k0 = 0; k0 < count; k0 += block) {
+			const int k1 = std::min(count, k0 + block);
+			double * o = out + k0;
+			const double * t = &table[0];
+			std::fill(o, out + k1, 0.0);
+			for (int i = 0; i < len; ++i) {
+				const unsigned char * c = &chars[k0 + i];
+				for (int k = 0; k < k1 - k0; ++k) {
+					o[k] += t[c[k]];
+				}
+				t += alphasize + 1;
+			}
+		}
+
+		// windows which contain only unknown characters score zero
+		int matched = 0;
+		for (int i = 0; i < len - 1; ++i) {
+			matched += chars[i] < alphasize;
+		}
+		for (int k = 0; k < count; ++k) {
+			matched += chars[k + len - 1] < alphasize;
+			if (matched == 0 || out[k] < min_sc_n) {
+				out[k] = 0;
+			} else {
+				out[k] -= min_sc_n;
+			}
+			matched -= chars[k] < alphasize;
+		}
+	}
+
+	/** batch scoring through the PSSM_Score interface */
+	void score_all (string const & sequence, int from, int to, double * out) {
+		score_range(sequence, from, to, out);
+	}
+
+	/**
+	 * The normalized log-odds table, (alphasize + 1) entries per position
+	 */
+	std::vector<double> const & get_table () const {
+		return table;
+	}
+
+	/**
+	 * Normalized minimum score, which is subtracted from sums of table entries
+	 */
+	double get_min_table_score () const {
+		return min_sc_n;
+	}
+
+	/** the score is additive, see PSSM_Score */
+	bool get_additive_table (std::vector<double> & _table, size_t & alphabet, double & offset) {
+		_table = table;
+		alphabet = alphasize;
+		offset = min_sc_n;
+		return true;
 	}
 
 	/**
@@ -114,10 +192,38 @@ public:
 	}
 
 private:
+	/**
+	 * Precompute normalized log-odds scores for every position and
+	 * character. Column alphasize is zero and is used for characters
+	 * outside the alphabet.
+	 */
+	void make_table () {
+		using namespace std;
+		const int len = (int)pssm.get_length();
+		table.resize(len * (alphasize + 1));
+		for (int i = 0; i < len; ++i) {
+			for (int c = 0; c < alphasize; ++c) {
+				double psc = pssm(pssm.begin() + i, c);
+				if (psc < DBL_EPSILON) {
+					psc = DBL_EPSILON;
+				}
+				table[i * (alphasize + 1) + c] = log (4 * psc) / n_sc;
+			}
+			table[i * (alphasize + 1) + alphasize] = 0;
+		}
+		min_sc_n = min_sc / n_sc;
+	}
+
 	double min_sc;
 	double n_sc;
+	double min_sc_n;
 
 	_PSSM pssm;
+
+	/** normalized log-odds, (alphasize + 1) entries per position */
+	std::vector<double> table;
+	/** translated characters for score_range */
+	std::vector<unsigned char> chars;
 };
 
 
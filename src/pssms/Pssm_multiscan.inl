@@ -0,0 +1,319 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __Pssm_multiscan_H__
+#define __Pssm_multiscan_H__
+
+/**
+ * Scan a sequence with many multiplicative PSSM scores at once.
+ *
+ * The sequence is translated once, and then processed in tiles of
+ * offsets which stay in the cache while all matrices are evaluated
+ * on them. The log-odds tables of all matrices are stored in one
+ * array.
+ *
+ * Scores are the same as the ones given by
+ * PSSM_Multiplicative_Score::score.
+ *
+ * With lookahead enabled (the default), offsets are abandoned as soon
+ * as the partial score plus the maximum score of the remaining
+ * positions cannot exceed the threshold (see Wu et al., "Fast
+ * probabilistic analysis of sequence function using scoring matrices",
+ * Bioinformatics 16(3), 2000). Positions are visited in order of
+ * decreasing expected loss against their best character, so most
+ * offsets are abandoned after a few positions. Offsets which are not
+ * abandoned are scored again in the same order as in score(), so this
+ * only changes the amount of work, not the reported hits.
+ */
+template <class string, size_t alphasize = 4 >
+class PSSM_Multi_Scanner {
+public:
+	typedef PSSM_Multiplicative_Score<string, alphasize> score_t;
+
+	enum {
+		/** number of offsets which are scored together */
+		TILE = 256
+	};
+
+	/** scores are normalized to [0, 1], this covers rounding differences */
+	static double const LOOKAHEAD_SLACK;
+
+	PSSM_Multi_Scanner () : max_length(0), lookahead(true) {}
+
+	/**
+	 * Add a score function
+	 *
+	 * @param sc        : the score function
+	 * @param threshold : report scores above this value
+	 *
+	 * @return the index of the score in this scanner
+	 */
+	int add (score_t const & sc, double threshold) {
+		return add_table(sc, threshold, false);
+	}
+
+	/**
+	 * Add a score function for the reverse strand
+	 *
+	 * Hits are reported at the forward offset of the window which
+	 * gives the same score as score() on the reverse complement of the
+	 * window (with complement(c) = alphasize - 1 - c, like
+	 * datamodel::reverse_complement).
+	 *
+	 * @param sc        : the score function
+	 * @param threshold : report scores above this value
+	 *
+	 * @return the index of the score in this scanner
+	 */
+	int add_reverse_complement (score_t const & sc, double threshold) {
+		return add_table(sc, threshold, true);
+	}
+
+	/** remove all score functions */
+	void clear () {
+		tables.clear();
+		la_tables.clear();
+		la_order.clear();
+		rest_max.clear();
+		matrices.clear();
+		max_length = 0;
+	}
+
+	/** the number of score functions */
+	size_t size () const {
+		return matrices.size();
+	}
+
+	/** enable / disable lookahead scoring */
+	void set_lookahead (bool l) {
+		lookahead = l;
+	}
+
+	/** the maximum length of all score functions */
+	int get_max_length () const {
+		return max_length;
+	}
+
+	/** the length of score function m */
+	int get_length (int m) const {
+		return matrices[m].length;
+	}
+
+	/**
+	 * Score all windows which fit into [from, to) with all score
+	 * functions.
+	 *
+	 * For every score above the threshold of its function,
+	 * hit(m, k, score) is called with the index of the function,
+	 * the offset in the sequence and the score.
+	 *
+	 * @param sequence : a sequence (template class must support operator [] which returns something int)
+	 * @param from     : start of the range to scan
+	 * @param to       : end of the range (exclusive)
+	 * @param hit      : hit callback
+	 */
+	template <class hit_fn>
+	void scan (string const & sequence, int from, int to, hit_fn & hit) {
+		const int count = to - from;
+		if (count <= 0 || matrices.empty()) {
+			return;
+		}
+
+		// translate once, and count known characters so windows without
+		// any of these can be given score zero like in score()
+		chars.resize(count);
+		known.resize(count + 1);
+		known[0] = 0;
+		for (int j = 0; j < count; ++j) {
+			int ch = (int)sequence[from + j];
+			chars[j] = (unsigned char) (ch < alphasize ? ch : alphasize);
+			known[j + 1] = known[j] + (ch < alphasize ? 1 : 0);
+		}
+
+		double sums[TILE];
+		int alive[TILE];
+		for (int k0 = 0; k0 < count; k0 += TILE) {
+			for (size_t m = 0; m < matrices.size(); ++m) {
+				matrix const & mx (matrices[m]);
+				const int n = std::min((int)TILE, count - mx.length + 1 - k0);
+				if (n <= 0) {
+					continue;
+				}
+
+				const double * t = &tables[mx.table_start];
+				if (lookahead && mx.threshold >= 0) {
+					// when the threshold is negative, all offsets are reported.
+					// otherwise, we can skip offsets which can't reach
+					// min_n + threshold, allowing for some rounding error.
+					const double bound = mx.min_n + mx.threshold - LOOKAHEAD_SLACK;
+					const size_t p0 = mx.table_start / (alphasize + 1);
+					const double * lt = &la_tables[mx.table_start];
+					const int * order = &la_order[p0];
+					const double * r = &rest_max[p0];
+
+					// score all offsets until most of them can't reach the
+					// bound anymore
+					int n_alive = n;
+					int j = 0;
+					double b = 0;
+					std::fill(sums, sums + n, 0.0);
+					while (j < mx.length && n_alive * 2 > n) {
+						const unsigned char * c = &chars[k0 + order[j]];
+						b = bound - r[j];
+						n_alive = 0;
+						for (int k = 0; k < n; ++k) {
+							double s = sums[k] + lt[c[k]];
+							sums[k] = s;
+							n_alive += (int)(s >= b);
+						}
+						lt += alphasize + 1;
+						++j;
+					}
+
+					// then continue with the remaining ones
+					n_alive = 0;
+					for (int k = 0; k < n; ++k) {
+						alive[n_alive] = k;
+						n_alive += (int)(sums[k] >= b);
+					}
+					for (; j < mx.length && n_alive > 0; ++j) {
+						const unsigned char * c = &chars[k0 + order[j]];
+						b = bound - r[j];
+						int n_next = 0;
+						for (int a = 0; a < n_alive; ++a) {
+							const int k = alive[a];
+							double s = sums[k] + lt[c[k]];
+							sums[k] = s;
+							alive[n_next] = k;
+							n_next += (int)(s >= b);
+						}
+						n_alive = n_next;
+						lt += alphasize + 1;
+					}
+
+					// exact scores for the offsets which were not abandoned
+					std::fill(sums, sums + n, -DBL_MAX);
+					for (int a = 0; a < n_alive; ++a) {
+						const int k = alive[a];
+						const unsigned char * c = &chars[k0 + k];
+						double s = 0;
+						for (int ii = 0; ii < mx.length; ++ii) {
+							const int i = mx.reversed ? mx.length - 1 - ii : ii;
+							s += t[i * (alphasize + 1) + c[i]];
+						}
+						sums[k] = s;
+					}
+				} else {
+					std::fill(sums, sums + n, 0.0);
+					for (int ii = 0; ii < mx.length; ++ii) {
+						const int i = mx.reversed ? mx.length - 1 - ii : ii;
+						const unsigned char * c = &chars[k0 + i];
+						const double * ti = t + i * (alphasize + 1);
+						for (int k = 0; k < n; ++k) {
+							sums[k] += ti[c[k]];
+						}
+					}
+				}
+
+				for (int k = 0; k < n; ++k) {
+					double s = sums[k];
+					if (s < mx.min_n || known[k0 + k + mx.length] == known[k0 + k]) {
+						s = 0;
+					} else {
+						s -= mx.min_n;
+					}
+					if (s > mx.threshold) {
+						hit((int)m, from + k0 + k, s);
+					}
+				}
+			}
+		}
+	}
+
+private:
+	struct matrix {
+		size_t table_start;
+		int length;
+		double min_n;
+		double threshold;
+		/** rows are summed up in reverse order to match score() on the reverse strand */
+		bool reversed;
+	};
+
+	/** add the table of a score function, reversed and complemented if rc is true */
+	int add_table (score_t const & sc, double threshold, bool rc) {
+		std::vector<double> t (sc.get_table());
+		matrix m;
+		m.table_start = tables.size();
+		m.length = (int) (t.size() / (alphasize + 1));
+		m.min_n = sc.get_min_table_score();
+		m.threshold = threshold;
+		m.reversed = rc;
+		if (rc) {
+			std::vector<double> const & st (sc.get_table());
+			for (int i = 0; i < m.length; ++i) {
+				for (int c = 0; c < (int)alphasize; ++c) {
+					t[i * (alphasize + 1) + c] =
+						st[(m.length - 1 - i) * (alphasize + 1) + alphasize - 1 - c];
+				}
+			}
+		}
+		tables.insert(tables.end(), t.begin(), t.end());
+
+		// lookahead order: positions with the largest difference between
+		// the best and the average character come first
+		const size_t p0 = m.table_start / (alphasize + 1);
+		std::vector< std::pair<double, int> > loss (m.length);
+		for (int i = 0; i < m.length; ++i) {
+			const double * ti = &t[i * (alphasize + 1)];
+			double mean = 0;
+			for (int c = 0; c < (int)alphasize; ++c) {
+				mean += ti[c];
+			}
+			mean /= alphasize;
+			loss[i] = std::make_pair(mean - *std::max_element(ti, ti + alphasize + 1), i);
+		}
+		std::stable_sort(loss.begin(), loss.end());
+
+		// permuted tables, and maximum score of the positions after j
+		la_tables.resize(tables.size());
+		la_order.resize(p0 + m.length);
+		rest_max.resize(p0 + m.length);
+		for (int j = 0; j < m.length; ++j) {
+			const int i = loss[j].second;
+			la_order[p0 + j] = i;
+			std::copy(&t[i * (alphasize + 1)], &t[(i + 1) * (alphasize + 1)],
+				&la_tables[m.table_start + j * (alphasize + 1)]);
+		}
+		double r = 0;
+		for (int j = m.length - 1; j >= 0; --j) {
+			rest_max[p0 + j] = r;
+			const double * tj = &la_tables[m.table_start + j * (alphasize + 1)];
+			r += *std::max_element(tj, tj + alphasize + 1);
+		}
+		matrices.push_back(m);
+		max_length = std::max(max_length, m.length);
+		return (int)matrices.size() - 1;
+	}
+
+	/** log-odds tables of all score functions, (alphasize + 1) entries per position */
+	std::vector<double> tables;
+	/** tables in lookahead order, original position and maximum score of the remaining positions */
+	std::vector<double> la_tables;
+	std::vector<int> la_order;
+	std::vector<double> rest_max;
+	std::vector<matrix> matrices;
+	int max_length;
+	bool lookahead;
+
+	/** translated characters and prefix counts of known characters */
+	std::vector<unsigned char> chars;
+	std::vector<int> known;
+};
+
+template <class string, size_t alphasize>
+double const PSSM_Multi_Scanner<string, alphasize>::LOOKAHEAD_SLACK = 1e-9;
+
+#endif // __Pssm_multiscan_H__
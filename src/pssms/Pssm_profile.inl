@@ -14,6 +14,16 @@
 #define PSSM_HIST_SAMPLES 20000000l
 #endif
 
+/** score steps per histogram bucket in exact histograms */
+#ifndef PSSM_HIST_GRANULARITY
+#define PSSM_HIST_GRANULARITY 4
+#endif
+
+/** maximum number of DP cells (contexts * score steps) in exact histograms */
+#ifndef PSSM_HIST_MAX_CELLS
+#define PSSM_HIST_MAX_CELLS 16000000l
+#endif
+
 /************************************************************************/
 /* Score Histogram class to produce PSSM scoring p-values using         */
 /* a background model                                                   */
@@ -39,8 +49,12 @@ public:
 	 * Create a histogram given a PSSM, a sequence background model, and 
 	 * a score function.
 	 * 
-	 * We can also restrict the range of a histogram via a best and worst 
-	 * right-tail p-value.
+	 * If the score function is additive and the background model gives 
+	 * its transition probabilities, the distribution of scores is 
+	 * computed exactly (up to discretisation of the score values) by 
+	 * dynamic programming over the PSSM positions. Otherwise, it is 
+	 * estimated from PSSM_HIST_SAMPLES positions in a sequence generated
+	 * from the background model.
 	 * 
 	 * \param [ps] the score function
 	 * \param [model] the sequence background model
@@ -50,31 +64,33 @@ public:
 	void make_histogram( 
 		PSSM_Score <_string> * ps,
 		sequencemodel::SequenceModel< _string > * model ) {
-		using namespace std;
-		using namespace utilities;
-
-		// the more accuracy we want on the pvals, the more samples
-		// we need.
-		size_t samples = PSSM_HIST_SAMPLES;
-
-		tail_scores.resize( PSSM_HIST_NBUCKETS );
+		std::vector<double> table, probs;
+		size_t alphabet, model_alphabet;
+		double offset;
+		int order;
 
-		for (int j = 0; j < PSSM_HIST_NBUCKETS; ++j) {
-			tail_scores[j] = 0;
+		if (   ps->get_additive_table(table, alphabet, offset)
+			&& model->get_transition_probabilities(order, model_alphabet, probs)
+			&& alphabet == model_alphabet ) {
+			exact_histogram(table, alphabet, offset, order, probs);
+		} else {
+			sample_histogram(ps, model);
 		}
+	}
 
-		_string v= model->generate_sequence(samples + ps->min_length());
-		for (int k = 0; k < samples; ++k) {
-			double score = ps->score(v, k);
-			if(score < 0 || score > 1) {
-				score = -1;
-			}
-			tail_scores[ (size_t)(score * ((double)PSSM_HIST_NBUCKETS-1))]++;
-		}
+	/**
+	 * The (unnormalized) right tail probabilities for all buckets
+	 */
+	std::vector<double> const & get_tail_scores () const {
+		return tail_scores;
+	}
 
-		for (int j = PSSM_HIST_NBUCKETS-2; j >= 0; --j) {
-			tail_scores[j] += tail_scores[j+1];
-		}
+	/**
+	 * Set the right tail probabilities for all buckets
+	 */
+	template <class iterator>
+	void set_tail_scores ( iterator begin, iterator end ) {
+		tail_scores.assign(begin, end);
 	}
 
 	/**
@@ -147,15 +163,167 @@ public:
 	}
 	
 private:
+	/**
+	 * Estimate the histogram by scoring a random sequence
+	 */
+	void sample_histogram( 
+		PSSM_Score <_string> * ps,
+		sequencemodel::SequenceModel< _string > * model ) {
+		using namespace std;
+		using namespace utilities;
+
+		// the more accuracy we want on the pvals, the more samples
+		// we need.
+		size_t samples = PSSM_HIST_SAMPLES;
+
+		tail_scores.resize( PSSM_HIST_NBUCKETS );
+
+		for (int j = 0; j < PSSM_HIST_NBUCKETS; ++j) {
+			tail_scores[j] = 0;
+		}
+
+		_string v= model->generate_sequence(samples + ps->min_length());
+		for (int k = 0; k < samples; ++k) {
+			double score = ps->score(v, k);
+			if(score < 0 || score > 1) {
+				score = -1;
+			}
+			tail_scores[ (size_t)(score * ((double)PSSM_HIST_NBUCKETS-1))]++;
+		}
+
+		for (int j = PSSM_HIST_NBUCKETS-2; j >= 0; --j) {
+			tail_scores[j] += tail_scores[j+1];
+		}
+	}
+
+	/**
+	 * Compute the histogram for an additive score on a Markov background.
+	 * 
+	 * Table entries are rounded to multiples of a bucket width divided by
+	 * PSSM_HIST_GRANULARITY. For every position, context and rounded 
+	 * partial score we store the probability of reaching it; the initial
+	 * contexts follow the stationary distribution of the model.
+	 * 
+	 * \param [table] score table, alphabet + 1 entries per position
+	 * \param [alphabet] the alphabet size
+	 * \param [offset] the value to subtract from sums of table entries
+	 * \param [order] number of context characters in the model
+	 * \param [probs] transition probabilities, see SequenceModel
+	 */
+	void exact_histogram ( 
+		std::vector<double> const & table, size_t alphabet, double offset,
+		int order, std::vector<double> const & probs ) {
+		using namespace std;
+
+		const int A = (int)alphabet;
+		const int len = (int)(table.size() / (A + 1));
+		int S = 1;
+		for (int j = 0; j < order; ++j) {
+			S *= A;
+		}
+		// the new character becomes the most significant one in the context
+		const int shift = S / A;
+
+		// stationary distribution of contexts
+		vector<double> pi (S, 1.0 / S), pi_next (S);
+		for (int it = 0; it < 10000; ++it) {
+			std::fill(pi_next.begin(), pi_next.end(), 0.0);
+			for (int s = 0; s < S; ++s) {
+				for (int c = 0; c < A; ++c) {
+					pi_next[s / A + c * shift] += pi[s] * probs[s * A + c];
+				}
+			}
+			double diff = 0;
+			for (int s = 0; s < S; ++s) {
+				diff = max (diff, fabs (pi_next[s] - pi[s]));
+			}
+			pi.swap(pi_next);
+			if (diff < DBL_EPSILON) {
+				break;
+			}
+		}
+
+		// choose the score resolution such that the DP fits into memory
+		vector<double> col_min (len), col_max (len);
+		double span = 0, lo = 0;
+		for (int i = 0; i < len; ++i) {
+			const double * t = &table[i * (A + 1)];
+			col_min[i] = *std::min_element(t, t + A);
+			col_max[i] = *std::max_element(t, t + A);
+			span += col_max[i] - col_min[i];
+			lo += col_min[i];
+		}
+		int granularity = PSSM_HIST_GRANULARITY;
+		while (granularity > 1 &&
+			S * (span * (PSSM_HIST_NBUCKETS - 1) * granularity + len + 1) > PSSM_HIST_MAX_CELLS) {
+			granularity /= 2;
+		}
+		const double delta = 1.0 / ((PSSM_HIST_NBUCKETS - 1) * (double)granularity);
+
+		vector<int> w (len * A);
+		int R = 1;
+		for (int i = 0; i < len; ++i) {
+			int w_max = 0;
+			for (int c = 0; c < A; ++c) {
+				w[i * A + c] = (int)floor((table[i * (A + 1) + c] - col_min[i]) / delta + 0.5);
+				w_max = max (w_max, w[i * A + c]);
+			}
+			R += w_max;
+		}
+
+		// q[s * R + b] : probability of context s and partial score lo + b * delta
+		vector<double> q (S * R, 0.0), q_next (S * R);
+		for (int s = 0; s < S; ++s) {
+			q[s * R] = pi[s];
+		}
+		int hi = 0;
+		for (int i = 0; i < len; ++i) {
+			int w_max = *std::max_element(&w[i * A], &w[i * A] + A);
+			std::fill(q_next.begin(), q_next.end(), 0.0);
+			for (int s = 0; s < S; ++s) {
+				const double * src = &q[s * R];
+				for (int c = 0; c < A; ++c) {
+					const double p = probs[s * A + c];
+					if (p <= 0) {
+						continue;
+					}
+					double * dst = &q_next[(s / A + c * shift) * R + w[i * A + c]];
+					for (int b = 0; b <= hi; ++b) {
+						dst[b] += p * src[b];
+					}
+				}
+			}
+			q.swap(q_next);
+			hi += w_max;
+		}
+
+		tail_scores.resize( PSSM_HIST_NBUCKETS );
+		std::fill(tail_scores.begin(), tail_scores.end(), 0.0);
+		for (int b = 0; b <= hi; ++b) {
+			double mass = 0;
+			for (int s = 0; s < S; ++s) {
+				mass += q[s * R + b];
+			}
+			double score = lo + b * delta - offset;
+			score = max (0.0, min (1.0, score));
+			tail_scores[ (size_t)(score * ((double)PSSM_HIST_NBUCKETS-1))] += mass;
+		}
+
+		for (int j = PSSM_HIST_NBUCKETS-2; j >= 0; --j) {
+			tail_scores[j] += tail_scores[j+1];
+		}
+	}
+
 	/************************************************************************/
 	/* Serialization code                                                   */
 	/************************************************************************/
 	JSONIZE_AS (
 		"Datatypes::Motifs::PSSM_Profile", 
 		PSSM_Histogram, 1, 
-		S_STORE(tail_scores, JSONArray< JSONInt<> >)
+		S_STORE(tail_scores, JSONArray< JSONDouble<> >)
 	);
-	std::vector<int> tail_scores;
+	/** tail_scores[j]: (unnormalized) probability of scoring in bucket j or higher */
+	std::vector<double> tail_scores;
 };
 
 
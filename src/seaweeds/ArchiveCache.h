@@ -0,0 +1,230 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SEAWEEDS_ARCHIVECACHE_H__
+#define __SEAWEEDS_ARCHIVECACHE_H__
+
+#include "autoconfig.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#include <boost/filesystem.hpp>
+
+namespace seaweeds {
+
+/**
+ * \brief Persistent, content-addressed cache for seaweed permutations.
+ *
+ * Archives are stored as one file per (x, y, omega, bpc) combination in
+ * the cache directory. The file name is a hash of the inputs, the file
+ * contains a second, independent hash to detect collisions.
+ *
+ * File format (all integers as LEB128 varints):
+ *   magic "SWA1", m, n, omega, bpc, check hash (64 bit),
+ *   followed by m+n zigzag-encoded values seaweedpermutation[j] - j + m.
+ *
+ * Seaweeds which don't start too far from their end point give small
+ * values here, so most entries take one or two bytes.
+ *
+ * The cache is disabled until a directory is set. The AlignmentPlot app
+ * sets it from the global option Seaweeds::archive_cache.
+ */
+class ArchiveCache {
+public:
+	typedef std::vector<int> archive;
+
+	/** set the cache directory. Pass an empty string to disable caching. */
+	static void set_directory(std::string const & dir) {
+		directory() = dir;
+	}
+
+	/** true if a cache directory was set */
+	static bool enabled() {
+		return !directory().empty();
+	}
+
+	/**
+	 * \brief try to load an archive for the given inputs
+	 *
+	 * \return true if the archive was found and read completely
+	 */
+	template <class _string>
+	static bool load(_string const & x, _string const & y,
+		size_t omega, size_t bpc, archive & a) {
+		if (!enabled()) {
+			return false;
+		}
+		UINT64 check;
+		std::string fn = filename(x, y, omega, bpc, check);
+		std::ifstream f(fn.c_str(), std::ios::in | std::ios::binary);
+		if (!f.good()) {
+			return false;
+		}
+		char magic[4];
+		f.read(magic, 4);
+		if (!f.good() || magic[0] != 'S' || magic[1] != 'W' || magic[2] != 'A' || magic[3] != '1') {
+			return false;
+		}
+		UINT64 m, n, o, b, c;
+		if (   !read_varint(f, m) || !read_varint(f, n)
+			|| !read_varint(f, o) || !read_varint(f, b)
+			|| !read_varint(f, c) ) {
+			return false;
+		}
+		if (m != x.size() || n != y.size() || o != omega || b != bpc || c != check) {
+			return false;
+		}
+		size_t mn = (size_t)(m + n);
+		if (a.size() < mn) {
+			a.resize(mn);
+		}
+		for (size_t j = 0; j < mn; ++j) {
+			UINT64 v;
+			if (!read_varint(f, v)) {
+				return false;
+			}
+			a[j] = unzigzag(v) + (int)j - (int)m;
+		}
+		return true;
+	}
+
+	/**
+	 * \brief store an archive for the given inputs
+	 *
+	 * The file is written under a unique temporary name first and then
+	 * renamed, so concurrent readers (also in other processes sharing
+	 * the directory) never see partial archives. Failures are ignored,
+	 * the cache is only an optimization.
+	 */
+	template <class _string>
+	static void store(_string const & x, _string const & y,
+		size_t omega, size_t bpc, archive const & a) {
+		if (!enabled()) {
+			return;
+		}
+		UINT64 check;
+		std::string fn = filename(x, y, omega, bpc, check);
+		std::string tmpname;
+		try {
+			tmpname = fn + "." + boost::filesystem::unique_path().string() + ".tmp";
+		} catch (boost::filesystem::filesystem_error &) {
+			return;
+		}
+		{
+			std::ofstream f(tmpname.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!f.good()) {
+				return;
+			}
+			size_t m = x.size();
+			size_t n = y.size();
+			f.write("SWA1", 4);
+			write_varint(f, m);
+			write_varint(f, n);
+			write_varint(f, omega);
+			write_varint(f, bpc);
+			write_varint(f, check);
+			for (size_t j = 0; j < m + n; ++j) {
+				write_varint(f, zigzag(a[j] - (int)j + (int)m));
+			}
+			if (!f.good()) {
+				f.close();
+				std::remove(tmpname.c_str());
+				return;
+			}
+		}
+		if (std::rename(tmpname.c_str(), fn.c_str()) != 0) {
+			std::remove(tmpname.c_str());
+		}
+	}
+
+	/**
+	 * \brief compute the cache file name for a set of inputs
+	 *
+	 * \param check receives the collision check hash
+	 */
+	template <class _string>
+	static std::string filename(_string const & x, _string const & y,
+		size_t omega, size_t bpc, UINT64 & check) {
+		// FNV-1a with two different offset bases
+		UINT64 h = 14695981039346656037ULL;
+		check = 0x84222325cbf29ce4ULL;
+		size_t header[4] = { x.size(), y.size(), omega, bpc };
+		for (int j = 0; j < 4; ++j) {
+			hash_value(h, check, (UINT64)header[j]);
+		}
+		for (size_t j = 0; j < x.size(); ++j) {
+			hash_value(h, check, (UINT64)x.get(j));
+		}
+		for (size_t j = 0; j < y.size(); ++j) {
+			hash_value(h, check, (UINT64)y.get(j));
+		}
+		std::ostringstream fn;
+		fn << directory() << "/sw_"
+		   << std::hex << std::setw(16) << std::setfill('0') << h
+		   << ".swa";
+		return fn.str();
+	}
+
+private:
+	static std::string & directory() {
+		static std::string dir;
+		return dir;
+	}
+
+	static void hash_value(UINT64 & h1, UINT64 & h2, UINT64 v) {
+		for (int k = 0; k < 8; ++k) {
+			UINT64 b = v & 0xff;
+			h1 = (h1 ^ b) * 1099511628211ULL;
+			h2 = (h2 ^ b) * 0x100000001b3ULL + 0x9e3779b97f4a7c15ULL;
+			v >>= 8;
+		}
+	}
+
+	static UINT64 zigzag(int v) {
+		return (v < 0) ? ((((UINT64)(-(INT64)v)) << 1) - 1) : (((UINT64)v) << 1);
+	}
+
+	static int unzigzag(UINT64 v) {
+		return (v & 1) ? -(int)((v + 1) >> 1) : (int)(v >> 1);
+	}
+
+	static void write_varint(std::ostream & o, UINT64 v) {
+		char buf[10];
+		int l = 0;
+		do {
+			char c = (char)(v & 0x7f);
+			v >>= 7;
+			if (v != 0) {
+				c |= 0x80;
+			}
+			buf[l++] = c;
+		} while (v != 0);
+		o.write(buf, l);
+	}
+
+	static bool read_varint(std::istream & i, UINT64 & v) {
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			int c = i.get();
+			if (c == EOF) {
+				return false;
+			}
+			v |= ((UINT64)(c & 0x7f)) << shift;
+			if ((c & 0x80) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+};
+
+};
+
+#endif
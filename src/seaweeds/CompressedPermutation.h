@@ -0,0 +1,145 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SEAWEEDS_COMPRESSEDPERMUTATION_H__
+#define __SEAWEEDS_COMPRESSEDPERMUTATION_H__
+
+#include "autoconfig.h"
+
+#include <vector>
+
+namespace seaweeds {
+
+/**
+ * \brief Compressed storage for seaweed permutations.
+ *
+ * Entries are stored as differences to their predecessor, zigzag and
+ * varint encoded. Every block_size entries, the value is stored in full
+ * and its byte offset is recorded, so random access needs to decode at
+ * most block_size - 1 differences.
+ *
+ * This can be used in place of ImplicitStorage::archive to keep many
+ * seaweed permutations in memory at once, see MultiSeaweeds.
+ */
+class CompressedPermutation {
+public:
+	enum {
+		block_size = 64,
+	};
+
+	CompressedPermutation() : len(0) {}
+
+	explicit CompressedPermutation(std::vector<int> const & p) : len(0) {
+		assign(p.empty() ? NULL : &p[0], p.size());
+	}
+
+	CompressedPermutation(const int * p, size_t _len) : len(0) {
+		assign(p, _len);
+	}
+
+	/** compress the first _len entries of p */
+	void assign(const int * p, size_t _len) {
+		len = _len;
+		data.clear();
+		blocks.clear();
+		blocks.reserve((len + block_size - 1) / block_size);
+		// typical seaweed permutations need less than two bytes per entry
+		data.reserve(2 * len);
+
+		int last = 0;
+		for (size_t j = 0; j < len; ++j) {
+			if (j % block_size == 0) {
+				blocks.push_back((unsigned int)data.size());
+				last = 0;
+			}
+			put(p[j] - last);
+			last = p[j];
+		}
+	}
+
+	/** random access */
+	int operator[] (size_t j) const {
+		const unsigned char * d = &data[blocks[j / block_size]];
+		int v = 0;
+		for (size_t k = j % block_size + 1; k > 0; --k) {
+			v += get(d);
+		}
+		return v;
+	}
+
+	/** decompress all entries into target */
+	void decompress(std::vector<int> & target) const {
+		if (target.size() < len) {
+			target.resize(len);
+		}
+		if (len == 0) {
+			return;
+		}
+		const unsigned char * d = &data[0];
+		int v = 0;
+		for (size_t j = 0; j < len; ++j) {
+			if (j % block_size == 0) {
+				v = 0;
+			}
+			v += get(d);
+			target[j] = v;
+		}
+	}
+
+	/** conversion to an uncompressed archive */
+	operator std::vector<int> () const {
+		std::vector<int> v;
+		decompress(v);
+		return v;
+	}
+
+	/** number of entries */
+	size_t size() const {
+		return len;
+	}
+
+	/** number of bytes used for storing the compressed data */
+	size_t memory_size() const {
+		return data.capacity() * sizeof(unsigned char)
+			+ blocks.capacity() * sizeof(unsigned int)
+			+ sizeof(*this);
+	}
+
+	/** free unused space after assigning */
+	void shrink() {
+		std::vector<unsigned char> (data).swap(data);
+		std::vector<unsigned int> (blocks).swap(blocks);
+	}
+
+private:
+	/** append a zigzag varint */
+	void put(int v) {
+		unsigned int z = (v < 0) ? ((((unsigned int)(-v)) << 1) - 1) : (((unsigned int)v) << 1);
+		while (z >= 0x80) {
+			data.push_back((unsigned char)(z | 0x80));
+			z >>= 7;
+		}
+		data.push_back((unsigned char)z);
+	}
+
+	/** read a zigzag varint and advance d */
+	static int get(const unsigned char * & d) {
+		unsigned int z = *d & 0x7f;
+		int shift = 7;
+		while (*d++ & 0x80) {
+			z |= ((unsigned int)(*d & 0x7f)) << shift;
+			shift += 7;
+		}
+		return (z & 1) ? -(int)((z + 1) >> 1) : (int)(z >> 1);
+	}
+
+	size_t len; ///< number of entries
+	std::vector<unsigned char> data; ///< varint data
+	std::vector<unsigned int> blocks; ///< byte offsets of each block in data
+};
+
+};
+
+#endif
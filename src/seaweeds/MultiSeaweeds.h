@@ -9,11 +9,17 @@
 
 namespace seaweeds {
 
-	template <class scorematrix>
+	/**
+	 * \brief compute and store multiple seaweed permutations
+	 *
+	 * _archive can be scorematrix::compressed_archive to reduce the 
+	 * memory used for storing the outputs.
+	 */
+	template <class scorematrix, class _archive = typename scorematrix::archive>
 	class MultiSeaweeds {
 	public:
 		typedef typename scorematrix::string string;
-		typedef typename scorematrix::archive scorearchive;
+		typedef _archive scorearchive;
 
 		MultiSeaweeds() {}
 		~MultiSeaweeds() {}
@@ -26,7 +32,7 @@ namespace seaweeds {
 			for (int _k = 0; _k < k; ++_k) {
 				scorematrix sm(x[_k].size(), y.size());
 				sm.semilocallcs(x[_k], y);
-				p_outputs[_k] = sm.get_archive();
+				p_outputs[_k] = scorearchive(sm.get_archive());
 			}
 		}
 
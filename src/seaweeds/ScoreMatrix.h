@@ -26,7 +26,11 @@ class ScoreMatrix : public _storage {
     	ScoreMatrix(int _m, int _n) : 
 			_storage(_m, _n) {}
 
-    	ScoreMatrix(int _m, int _n, archive _a) :
+    	ScoreMatrix(int _m, int _n, archive const & _a) :
+			_storage(_m, _n, _a) {}
+
+		template <class _archive>
+    	ScoreMatrix(int _m, int _n, _archive const & _a) :
 			_storage(_m, _n, _a) {}
 
 		/**
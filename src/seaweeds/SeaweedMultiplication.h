@@ -0,0 +1,243 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SEAWEEDS_SEAWEEDMULTIPLICATION_H__
+#define __SEAWEEDS_SEAWEEDMULTIPLICATION_H__
+
+#include <vector>
+#include <algorithm>
+
+namespace seaweeds {
+
+/**
+ * \brief Seaweed matrix multiplication (distance multiplication of
+ *        unit-Monge matrices) in O(n log n) time.
+ *
+ * Permutations are given as arrays p of length n, row r has its
+ * nonzero in column p[r]. With P^S(i, k) = #{r >= i : p[r] < k}, the
+ * product C = A * B satisfies
+ *
+ *    C^S(i, k) = min_j ( A^S(i, j) + B^S(j, k) ).
+ *
+ * This is the divide-and-conquer algorithm by Tiskin: split the shared
+ * index range, multiply the two halves recursively, and combine them by
+ * walking along the boundary between the regions where either half
+ * gives the minimum.
+ */
+class SeaweedMultiplication {
+public:
+	/**
+	 * \brief compute c = a * b for permutations of size n
+	 */
+	static void multiply(const int * a, const int * b, int * c, int n) {
+		if (n <= 0) {
+			return;
+		}
+		if (n == 1) {
+			c[0] = 0;
+			return;
+		}
+		int h = n / 2;
+
+		// split a by columns, b by rows and compress both
+		std::vector<int> a_lo_rows, a_hi_rows, a_lo, a_hi;
+		a_lo_rows.reserve(h);
+		a_hi_rows.reserve(n - h);
+		a_lo.reserve(h);
+		a_hi.reserve(n - h);
+		for (int r = 0; r < n; ++r) {
+			if (a[r] < h) {
+				a_lo_rows.push_back(r);
+				a_lo.push_back(a[r]);
+			} else {
+				a_hi_rows.push_back(r);
+				a_hi.push_back(a[r] - h);
+			}
+		}
+
+		std::vector<int> col_is_lo(n, 0), col_rank(n), b_lo_cols, b_hi_cols;
+		b_lo_cols.reserve(h);
+		b_hi_cols.reserve(n - h);
+		for (int j = 0; j < h; ++j) {
+			col_is_lo[b[j]] = 1;
+		}
+		for (int k = 0; k < n; ++k) {
+			if (col_is_lo[k]) {
+				col_rank[k] = (int)b_lo_cols.size();
+				b_lo_cols.push_back(k);
+			} else {
+				col_rank[k] = (int)b_hi_cols.size();
+				b_hi_cols.push_back(k);
+			}
+		}
+		std::vector<int> b_lo(h), b_hi(n - h);
+		for (int j = 0; j < h; ++j) {
+			b_lo[j] = col_rank[b[j]];
+		}
+		for (int j = h; j < n; ++j) {
+			b_hi[j - h] = col_rank[b[j]];
+		}
+
+		std::vector<int> c_lo(h), c_hi(n - h);
+		multiply(&a_lo[0], &b_lo[0], &c_lo[0], h);
+		multiply(&a_hi[0], &b_hi[0], &c_hi[0], n - h);
+
+		// expand: every row and column of c now has exactly one
+		// candidate point, either from the lo or from the hi product
+		combiner cb(n);
+		for (int r = 0; r < h; ++r) {
+			cb.add(a_lo_rows[r], b_lo_cols[c_lo[r]], true);
+		}
+		for (int r = 0; r < n - h; ++r) {
+			cb.add(a_hi_rows[r], b_hi_cols[c_hi[r]], false);
+		}
+		cb.combine(c);
+	}
+
+	/**
+	 * \brief compose seaweed permutations for x vs. y1 and x vs. y2 into
+	 *        the one for x vs. y1 y2.
+	 *
+	 * Permutations are in the format used by ImplicitStorage: entry t
+	 * gives the end point of the seaweed starting at t - m. They must
+	 * be complete (no untracked -1 entries).
+	 *
+	 * \param p1 permutation for x vs. y1, size m+n1
+	 * \param p2 permutation for x vs. y2, size m+n2
+	 * \param out receives the permutation for x vs. y1 y2, size m+n1+n2
+	 */
+	static void concatenate_y(const int * p1, const int * p2, int m, int n1, int n2, int * out) {
+		int N = m + n1 + n2;
+		std::vector<int> a(N), b(N);
+		// the seaweeds for x vs y1 pass on the seaweeds from y2 unchanged
+		for (int t = 0; t < m + n1; ++t) {
+			a[t] = p1[t];
+		}
+		for (int t = m + n1; t < N; ++t) {
+			a[t] = t;
+		}
+		// the seaweeds leaving y1 on the bottom are unchanged by x vs y2
+		for (int u = 0; u < n1; ++u) {
+			b[u] = u;
+		}
+		for (int u = n1; u < N; ++u) {
+			b[u] = n1 + p2[u - n1];
+		}
+		multiply(&a[0], &b[0], out, N);
+	}
+
+private:
+	/**
+	 * \brief helper for combining the lo and hi subproducts.
+	 *
+	 * With lo/hi points as above, the lo product gives the minimum
+	 * where delta(i, k) >= 0, the hi product where delta(i, k) < 0.
+	 *
+	 *   delta(i, k) = #{lo : row >= i, col >= k} - #{hi : row < i, col < k}
+	 *
+	 * delta is nonincreasing in both i and k, so the boundary is a
+	 * staircase which we can walk in O(n).
+	 */
+	class combiner {
+	public:
+		combiner(int _n) : n(_n), row_col(_n), row_lo(_n), col_row(_n), col_lo(_n) {}
+
+		void add(int r, int c, bool lo) {
+			row_col[r] = c;
+			row_lo[r] = lo;
+			col_row[c] = r;
+			col_lo[c] = lo;
+		}
+
+		void combine(int * out) {
+			// kstar[i] = smallest k with delta(i, k) < 0, or n+1
+			std::vector<int> kstar(n + 1);
+			int k = 0, d = 0;
+			for (int i = n; i >= 0; --i) {
+				while (k <= n && d >= 0) {
+					if (k == n) {
+						k = n + 1;
+						break;
+					}
+					d -= inc_col(k, i);
+					++k;
+				}
+				kstar[i] = k;
+				if (i > 0 && k <= n) {
+					d += inc_row(i - 1, k);
+				}
+			}
+
+			// points away from the boundary are taken from the
+			// subproduct which gives the minimum there
+			for (int r = 0; r < n; ++r) {
+				out[r] = -1;
+				int c = row_col[r];
+				if (row_lo[r] ? c + 1 < kstar[r + 1] : c >= kstar[r]) {
+					out[r] = c;
+				}
+			}
+
+			// cells on the boundary: evaluate the density of
+			// lo(i, k) + min(0, delta(i, k))
+			int wi = n, wk = 0, wd = 0;
+			for (int r = n - 1; r >= 0; --r) {
+				int c0 = std::max(0, kstar[r + 1] - 1);
+				int c1 = std::min(n - 1, kstar[r] - 1);
+				if (c0 > c1) {
+					continue;
+				}
+				// move walker to (r+1, c0)
+				while (wi > r + 1) {
+					wd += inc_row(wi - 1, wk);
+					--wi;
+				}
+				while (wk < c0) {
+					wd -= inc_col(wk, wi);
+					++wk;
+				}
+				while (wk > c0) {
+					wd += inc_col(wk - 1, wi);
+					--wk;
+				}
+				for (int c = c0; c <= c1; ++c) {
+					int d_bl = wd;								// delta(r+1, c)
+					int d_br = d_bl - inc_col(c, r + 1);		// delta(r+1, c+1)
+					int d_tl = d_bl + inc_row(r, c);			// delta(r, c)
+					int d_tr = d_tl - inc_col(c, r);			// delta(r, c+1)
+					int density = (row_lo[r] && row_col[r] == c) ? 1 : 0;
+					density += std::min(0, d_tr) - std::min(0, d_tl)
+							 - std::min(0, d_br) + std::min(0, d_bl);
+					if (density > 0) {
+						out[r] = c;
+					}
+					wd = d_br;
+					wk = c + 1;
+				}
+			}
+		}
+
+	private:
+		/** delta(i, k) - delta(i, k+1) */
+		int inc_col(int k, int i) const {
+			return col_lo[k] ? (col_row[k] >= i ? 1 : 0) : (col_row[k] < i ? 1 : 0);
+		}
+
+		/** delta(i, k) - delta(i+1, k) */
+		int inc_row(int i, int k) const {
+			return row_lo[i] ? (row_col[i] >= k ? 1 : 0) : (row_col[i] < k ? 1 : 0);
+		}
+
+		int n;
+		std::vector<int> row_col;
+		std::vector<char> row_lo;
+		std::vector<int> col_row;
+		std::vector<char> col_lo;
+	};
+};
+
+};
+
+#endif
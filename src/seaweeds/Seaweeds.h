@@ -38,6 +38,9 @@ public:
 	typedef _permutation_container permutation_container;
 	typedef utilities::IntegerVector<_omega> STATE_TYPE;
 
+	static const size_t omega = _omega; ///< bits per seaweed distance
+	static const size_t bpc = _bpc;	 ///< bits per character
+
 	/**
 	 *  * The starting points for the returned seaweeds are computed as follows.
 	 * 
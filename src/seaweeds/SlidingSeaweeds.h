@@ -0,0 +1,134 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __SEAWEEDS_SLIDINGSEAWEEDS_H__
+#define __SEAWEEDS_SLIDINGSEAWEEDS_H__
+
+#include <vector>
+#include <deque>
+#include <algorithm>
+
+#include "xasmlib/IntegerVector.h"
+
+namespace seaweeds {
+
+/**
+ * \brief Seaweeds for a fixed string x and a window which slides along
+ *        another string.
+ *
+ * Characters are appended at the back of the window and removed at
+ * the front, llcs() gives LLCS(x, window) after each update.
+ *
+ * Seaweeds are labelled with the stream position of the column they
+ * start on top of, seaweeds starting on the left get a label below
+ * all of these. In a mismatch cell, the seaweed with the larger label
+ * continues downwards, in a match cell, the one coming from the left
+ * does. The window LCS is the number of seaweeds which start on top
+ * of the window and leave on the right.
+ *
+ * append() combs the new column, which touches the m seaweeds that
+ * leave on the right, and the one entering from its top. remove() only
+ * moves the window start: the seaweeds of earlier columns are smaller
+ * than all seaweeds of the window, like the ones starting on the left,
+ * so the paths of the window seaweeds are the same as if the window
+ * had been compared on its own. Only the label of the removed column
+ * is looked at.
+ *
+ * The seaweeds which start on the left are not tracked individually,
+ * so only string-substring scores are available. LLCS is symmetric,
+ * so sliding a window along x against a fixed y is the transposed
+ * case: construct with y and stream the characters of x.
+ */
+template <int _bpc = 8>
+class SlidingSeaweeds {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	SlidingSeaweeds() : m(0), window_begin(0), window_end(0), on_right(0) {}
+
+	SlidingSeaweeds(string const & _x) {
+		set_x(_x);
+	}
+
+	/** set the fixed string and start with an empty window at position 0 */
+	void set_x(string const & _x) {
+		x = _x;
+		m = (int)x.size();
+		reset(0);
+	}
+
+	/** start with an empty window at a given stream position */
+	void reset(int pos) {
+		right.assign(m, pos - 1);
+		leaves_right.clear();
+		window_begin = pos;
+		window_end = pos;
+		on_right = 0;
+	}
+
+	/** append a character at the back of the window in O(m) time */
+	void append(int c) {
+		int down = window_end;
+		leaves_right.push_back(1);
+		++on_right;
+
+		int * r = m > 0 ? &right[0] : NULL;
+		for (int i = 0; i < m; ++i) {
+			if (x.get(i) == c || r[i] > down) {
+				std::swap(r[i], down);
+			}
+		}
+
+		// the seaweed leaving at the bottom
+		if (down >= window_begin) {
+			leaves_right[down - window_begin] = 0;
+			--on_right;
+		}
+		++window_end;
+	}
+
+	/** remove the character at the front of the window in O(1) time */
+	void remove() {
+		if (window_begin == window_end) {
+			return;
+		}
+		on_right -= leaves_right.front();
+		leaves_right.pop_front();
+		++window_begin;
+	}
+
+	/** LLCS(x, window) */
+	int llcs() const {
+		return on_right;
+	}
+
+	/** stream position of the first character in the window */
+	int begin() const {
+		return window_begin;
+	}
+
+	/** number of characters in the window */
+	int size() const {
+		return window_end - window_begin;
+	}
+
+private:
+	string x;
+	int m;
+
+	/** labels of the seaweeds leaving on the right, by row */
+	std::vector<int> right;
+
+	/** for each column of the window, whether its seaweed leaves on the right */
+	std::deque<char> leaves_right;
+
+	int window_begin;
+	int window_end;
+	int on_right;
+};
+
+};
+
+#endif
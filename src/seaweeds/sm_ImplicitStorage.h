@@ -10,6 +10,9 @@
 
 #include "rangesearching/Range2D.h"
 #include "seaweeds/Seaweeds.h"
+#include "seaweeds/ArchiveCache.h"
+#include "seaweeds/CompressedPermutation.h"
+#include "seaweeds/SeaweedMultiplication.h"
 
 namespace seaweeds {
 
@@ -25,12 +28,18 @@ public:
 	typedef rangesearching::Point2D<int> _point;
 	typedef typename _slcsfun::string string;
 	typedef std::vector<int> archive;
+	typedef CompressedPermutation compressed_archive;
 
-	ImplicitStorage (int _m, int _n) : m(_m), n(_n), seaweedpermutation() /*, rangetree(NULL) */ {
+	ImplicitStorage (int _m, int _n) : m(_m), n(_n), seaweedpermutation(), inverse_valid(false) /*, rangetree(NULL) */ {
 		ensure_sizes(m, n);
 	}
 
-	ImplicitStorage (int _m, int _n, archive const & a) : m(_m), n(_n), seaweedpermutation(a) /*, rangetree(NULL) */ {
+	ImplicitStorage (int _m, int _n, archive const & a) : m(_m), n(_n), seaweedpermutation(a), inverse_valid(false) /*, rangetree(NULL) */ {
+		ensure_sizes(m, n);
+	}
+
+	ImplicitStorage (int _m, int _n, compressed_archive const & a) : m(_m), n(_n), seaweedpermutation(), inverse_valid(false) /*, rangetree(NULL) */ {
+		a.decompress(seaweedpermutation);
 		ensure_sizes(m, n);
 	}
 
@@ -102,11 +111,15 @@ public:
 		for(int i = 0; i < n; ++i) {
 			y[i] = 0;
 		}
+		inverse_valid = false;
 	}
 
 	/**
 	 * \brief initialize as semi-local scores corresponding to comparing s1 and s2
 	 * 
+	 * If an ArchiveCache directory is set, the seaweed permutation is 
+	 * read from the cache when available, and stored there otherwise.
+	 * 
 	 * \param s1 string alongside the vertical edge of the alignment dag
 	 * \param s2 string alongside the horizontal edge of the alignment dag
 	 */
@@ -120,24 +133,54 @@ public:
 		ensure_sizes(m,n);
 		rangetree = boost::shared_ptr<_rangetree> ();
 
+		if (ArchiveCache::enabled()) {
+			if (ArchiveCache::load(s1, s2, _slcsfun::omega, _slcsfun::bpc, seaweedpermutation)) {
+				inverse_valid = false;
+				return;
+			}
+		}
+
 		_slcsfun f;
 		f(s1, s2, right, top, false, false);
 		seaweed_distances_to_permutation();
+
+		if (ArchiveCache::enabled()) {
+			ArchiveCache::store(s1, s2, _slcsfun::omega, _slcsfun::bpc, seaweedpermutation);
+		}
 	}
 
 	typedef enum _incremental_type {
 		APPEND_TO_X, 
 		APPEND_TO_Y, 
+		PREPEND_TO_X, 
+		PREPEND_TO_Y, 
 	} incremental_type;
 
 	/**
 	 * \brief Incremental LCS computation.
+	 * 
+	 * Prepending is implemented by appending to the reversed strings, 
+	 * which adds O(m+n) time for reversing the permutation twice.
+	 * 
+	 * For sliding windows, use SlidingSeaweeds, which only updates the 
+	 * seaweeds crossing the added or removed column.
 	 */
 	void incremental_semilocallcs(const string & s, incremental_type t = APPEND_TO_X) {
 		using namespace std;
 		_slcsfun f;
 		size_t mm = m+n;
+		inverse_valid = false;
 		switch(t) {
+			case PREPEND_TO_X: 
+			case PREPEND_TO_Y: 
+			{
+				string r(s);
+				r.reverse();
+				reverse_xy();
+				incremental_semilocallcs(r, t == PREPEND_TO_X ? APPEND_TO_X : APPEND_TO_Y);
+				reverse_xy();
+				break;
+			}
 			case APPEND_TO_X: 
 			{
 				x.append(s);
@@ -175,29 +218,8 @@ public:
 #ifdef _DEBUG_SEAWEEDS
 				cout << endl;
 #endif // _DEBUG_SEAWEEDS
-				for (size_t j = 0; j < s.size(); ++j) {
-					int v = right.get(j);
-#ifdef _DEBUG_SEAWEEDS
-					cout << "right [" << j << "] = " << v << endl;
-#endif // _DEBUG_SEAWEEDS
-					if(v < _slcsfun::permutation_container::lsbs) {
-						seaweedpermutation[n - v - 1 + m] = 
-							(int) (s.size() + n - j - 1);
-					}
-#ifdef _DEBUG_SEAWEEDS
-					cout << (int)(n - v - 1) << " -> " 
-						 << (int)(s.size() + n - j - 1) << endl;
-#endif // _DEBUG_SEAWEEDS
-				}
-				for (size_t j = 0; j < n; ++j) {
-					int v = top.get(j);
-					if(v < _slcsfun::permutation_container::lsbs) {
-						seaweedpermutation[j - v + m] = (int)j;
-					}
-#ifdef _DEBUG_SEAWEEDS
-					cout << (int)(j - v) << " -> " << (int)j << endl;
-#endif // _DEBUG_SEAWEEDS
-				}
+				scatter_right((int)s.size(), (int)s.size() + n - 1);
+				scatter_top(n, 0);
 
 				rangetree = boost::shared_ptr<_rangetree > ();
 				break;
@@ -235,33 +257,12 @@ public:
 				cout << endl;
 #endif // _DEBUG_SEAWEEDS
 				// These are the new seaweeds that reach the right side
-				for (int j = 0; j < m; ++j) {
-					int v = right.get(j);
-#ifdef _DEBUG_SEAWEEDS
-					cout << "right [" << j << "] = " << v << endl;
-#endif // _DEBUG_SEAWEEDS
-					if(v < _slcsfun::permutation_container::lsbs) {
-						size_t i = n - v - 1 + m;
-						size_t k = m + n - j - 1;
-						seaweedpermutation[i] = (int)k;
-#ifdef _DEBUG_SEAWEEDS
-						cout << i-m << " -> " << k << endl;
-#endif // _DEBUG_SEAWEEDS
-					}
-				}
+				scatter_right(m, m + n - 1);
 #ifdef _DEBUG_SEAWEEDS
 				cout << endl;
 #endif // _DEBUG_SEAWEEDS
-				for (int j = 0; (unsigned)j < s.size(); ++j) {
-					int v = top.get(j);
-					if(v < _slcsfun::permutation_container::lsbs) {
-						seaweedpermutation[j + n - v + m - s.size()] = 
-							(int) (j + n - s.size());
-					}
-#ifdef _DEBUG_SEAWEEDS
-					cout << (int)(j + n - v - s.size() ) << " -> " << (int)j + n - s.size() << endl;
-#endif // _DEBUG_SEAWEEDS
-				}
+				// ... and the ones that reach the bottom below the appended string
+				scatter_top((int)s.size(), n - (int)s.size());
 
 				rangetree = boost::shared_ptr <_rangetree> ();
 				break;
@@ -269,6 +270,40 @@ public:
 		}
 	}
 
+	/**
+	 * \brief Append the string y2 of another matrix for the same x to y.
+	 * 
+	 * This uses seaweed matrix multiplication and runs in 
+	 * O((m+n) log (m+n)) time. Both permutations must be complete, 
+	 * i.e. omega must be large enough to track all seaweed distances.
+	 * 
+	 * \return false if one of the permutations is incomplete
+	 */
+	bool concatenate_y(ImplicitStorage<_slcsfun, range> const & rhs) {
+		ASSERT(rhs.m == m);
+		for (int t = 0; t < m + n; ++t) {
+			if (seaweedpermutation[t] < 0) {
+				return false;
+			}
+		}
+		for (int t = 0; t < rhs.m + rhs.n; ++t) {
+			if (rhs.seaweedpermutation[t] < 0) {
+				return false;
+			}
+		}
+		std::vector<int> result(m + n + rhs.n);
+		SeaweedMultiplication::concatenate_y(&seaweedpermutation[0], 
+			&rhs.seaweedpermutation[0], m, n, rhs.n, &result[0]);
+		seaweedpermutation.swap(result);
+
+		n += rhs.n;
+		y.append(rhs.y);
+		ensure_sizes(m, n);
+		rangetree = boost::shared_ptr<_rangetree> ();
+		inverse_valid = false;
+		return true;
+	}
+
 	/**
 	 * \brief Compute the matrix for the reversed strings x' and y' in O(m+n) time.
 	 */
@@ -297,6 +332,7 @@ public:
 			seaweedpermutation[j] = new_nonzeros[mm -j - 1];
 		}
 		rangetree = boost::shared_ptr<_rangetree> ();
+		inverse_valid = false;
 	}
 
 	/**
@@ -315,9 +351,18 @@ public:
 	}
 
 	archive & get_archive() {
+		// the archive may be modified through the returned reference
+		inverse_valid = false;
 		return seaweedpermutation;
 	}
 
+	/**
+	 * \brief get a compressed copy of the seaweed permutation
+	 */
+	void get_compressed_archive(compressed_archive & a) {
+		a.assign(&seaweedpermutation[0], m+n);
+	}
+
 	size_t get_m() {
 		return m;
 	}
@@ -369,19 +414,21 @@ public:
 
 		size_t count = 0;
 		size_t score = min((size_t)m,windowlength);
-		int invalid = -1;
-		std::vector<int> inverse_seaweedpermutation(m+n, invalid);
-		int j;
+		int w = (int)windowlength;
 
-		// create inverse permutation
-		for (j = 0; j < m+n; ++j) {
-			if (seaweedpermutation[j] >= 0) {
-				inverse_seaweedpermutation[seaweedpermutation[j]] = j;
-			}
+		// the inverse permutation is recorded when converting the seaweed 
+		// distances in semilocallcs, we only rebuild it if the permutation 
+		// was changed in a different way.
+		if (!inverse_valid) {
+			build_inverse();
 		}
+		const int * perm = &seaweedpermutation[0];
+		const int * inverse = &inverse_seaweedpermutation[0];
 
-		j = -(int)m;
-		while(j <= n-windowlength) {
+		// windows starting before -score end before column 0, and all
+		// have the same score
+		int j = -(int)score;
+		while(j <= n-w) {
 #ifdef _SEAWEEDS_VERIFY
 			if(j >= 0) {
 				string tmp_text;
@@ -437,17 +484,17 @@ public:
 				}
 			}
 #endif
-			if(j >= 0 && score == m) {
+			if(j >= 0 && score == (size_t)m) {
 				++count;
 			}
 			if(rpt != NULL && j >= 0) {
 				(*rpt)((size_t)j, (double)score);
 			}
 
-			if(seaweedpermutation[j+m] >= 0 && seaweedpermutation[j+m] <= j+windowlength) {
+			if(perm[j+m] >= 0 && perm[j+m] <= j+w) {
 				score+= 1;
 			}
-			if(inverse_seaweedpermutation[j+windowlength] - m >= j) {
+			if(inverse[j+w] - m >= j) {
 				score-= 1;
 			}
 			++j;
@@ -462,40 +509,118 @@ protected:
 	boost::shared_ptr<_rangetree> rangetree; ///< pointer to range tree. this will be built the first time the distribution function is called.
 
 	std::vector<int> seaweedpermutation; ///< the seaweed permutation. entry i gives the column for the nonzero in row i-m
+	std::vector<int> inverse_seaweedpermutation; ///< inverse of seaweedpermutation, only valid if inverse_valid is set
+	bool inverse_valid; ///< true if inverse_seaweedpermutation matches seaweedpermutation
 
 	typename _slcsfun::permutation_container right; ///< The seaweed permutation in seaweed distance format, right outputs. Will only be valid directly after call to semilocallcs, kept here to avoid mallocs
 	typename _slcsfun::permutation_container top;	///< The seaweed permutation in seaweed distance format, top outputs. Will only be valid directly after call to semilocallcs, kept here to avoid mallocs
+	std::vector<int> unpacked_distances; ///< right or top unpacked to ints, kept here to avoid mallocs
 private:
 	/**
 	 * @brief convert seaweed distances to permutation form
+	 * 
+	 * The inverse permutation is recorded in the same pass, so 
+	 * query_y_windows does not need to compute it.
 	 */
 	void seaweed_distances_to_permutation() {
 		using namespace std;
 		ensure_sizes(m, n);
-		for (int j = 0; j < m; ++j) {
-			int v = right.get(j);
+		int invalid = -1;
+		std::fill(seaweedpermutation.begin(), seaweedpermutation.begin() + (m+n), invalid);
+		inverse_seaweedpermutation.resize(seaweedpermutation.size());
+		std::fill(inverse_seaweedpermutation.begin(), inverse_seaweedpermutation.begin() + (m+n), invalid);
+
+		scatter_right(m, m + n - 1, &inverse_seaweedpermutation[0]);
+		scatter_top(n, 0, &inverse_seaweedpermutation[0]);
+		inverse_valid = true;
+#ifdef _DEBUG_SEAWEEDS
+		cout << endl;
+#endif // _DEBUG_SEAWEEDS
+	}
+
+	/**
+	 * @brief store the first count seaweeds from right in the permutation
+	 * 
+	 * right[j] = v gives a seaweed from n - v - 1 (on the top) to 
+	 * col_base - j (on the bottom). If inverse is not NULL, the 
+	 * inverse permutation is written there.
+	 */
+	void scatter_right(int count, int col_base, int * inverse = NULL) {
+		using namespace std;
+		if (count <= 0) {
+			return;
+		}
+		if (unpacked_distances.size() < (size_t)count) {
+			unpacked_distances.resize(count);
+		}
+		right.unpack(&unpacked_distances[0], 0, count);
+
+		const int * d = &unpacked_distances[0];
+		int * perm = &seaweedpermutation[0];
+		int row_base = n + m - 1;
+		for (int j = 0; j < count; ++j) {
+			int v = d[j];
 #ifdef _DEBUG_SEAWEEDS
 			cout << "right [" << j << "] = " << v << endl;
 #endif // _DEBUG_SEAWEEDS
 			if(v < _slcsfun::permutation_container::lsbs) {
-				seaweedpermutation[n - v - 1 + m] =(int) (m + n - j - 1);
+				perm[row_base - v] = col_base - j;
+				if (inverse != NULL) {
+					inverse[col_base - j] = row_base - v;
+				}
 			} 
 #ifdef _DEBUG_SEAWEEDS
-			cout << (int)(n - v - 1) << " -> " << (int)(m + n - j - 1) << endl;
+			cout << row_base - v - m << " -> " << col_base - j << endl;
 #endif // _DEBUG_SEAWEEDS
 		}
-		for (int j = 0; j < n; ++j) {
-			int v = top.get(j);
+	}
+
+	/**
+	 * @brief store the first count seaweeds from top in the permutation
+	 * 
+	 * top[j] = v gives a seaweed from col_ofs + j - v (on the top) to 
+	 * col_ofs + j (on the bottom). If inverse is not NULL, the 
+	 * inverse permutation is written there.
+	 */
+	void scatter_top(int count, int col_ofs, int * inverse = NULL) {
+		using namespace std;
+		if (count <= 0) {
+			return;
+		}
+		if (unpacked_distances.size() < (size_t)count) {
+			unpacked_distances.resize(count);
+		}
+		top.unpack(&unpacked_distances[0], 0, count);
+
+		const int * d = &unpacked_distances[0];
+		int * perm = &seaweedpermutation[col_ofs + m];
+		for (int j = 0; j < count; ++j) {
+			int v = d[j];
 			if(v < _slcsfun::permutation_container::lsbs) {
-				seaweedpermutation[j - v + m] = j;
+				perm[j - v] = col_ofs + j;
+				if (inverse != NULL) {
+					inverse[col_ofs + j] = col_ofs + j - v + m;
+				}
 			}
 #ifdef _DEBUG_SEAWEEDS
-			cout << (int)(j - v) << " -> " << (int)j << endl;
+			cout << col_ofs + j - v << " -> " << col_ofs + j << endl;
 #endif // _DEBUG_SEAWEEDS
 		}
-#ifdef _DEBUG_SEAWEEDS
-		cout << endl;
-#endif // _DEBUG_SEAWEEDS
+	}
+
+	/**
+	 * @brief compute the inverse seaweed permutation
+	 */
+	void build_inverse() {
+		int invalid = -1;
+		inverse_seaweedpermutation.resize(seaweedpermutation.size());
+		std::fill(inverse_seaweedpermutation.begin(), inverse_seaweedpermutation.begin() + (m+n), invalid);
+		for (int j = 0; j < m+n; ++j) {
+			if (seaweedpermutation[j] >= 0) {
+				inverse_seaweedpermutation[seaweedpermutation[j]] = j;
+			}
+		}
+		inverse_valid = true;
 	}
 
 	/**
@@ -177,6 +177,21 @@ public:
 		return ((double)get_transition_frequency (kmer, character)) / get_kmer_count(kmer);
 	}
 
+	/**
+	 * Transition probabilities for all kmers, see SequenceModel
+	 */
+	bool get_transition_probabilities (int & order, size_t & alphabet, std::vector<double> & probs) const {
+		order = ORDER;
+		alphabet = CHARACTERS;
+		probs.resize(KMERS * CHARACTERS);
+		for (UINT64 kmer = 0; kmer < (UINT64)KMERS; ++kmer) {
+			for (UINT64 ch = 0; ch < CHARACTERS; ++ch) {
+				probs[kmer * CHARACTERS + ch] = get_transition_probability(kmer, ch);
+			}
+		}
+		return true;
+	}
+
 	/**
 	 * Get the index for a kmer string
 	 */
@@ -7,6 +7,7 @@
 #define __SequenceModel_H__
 
 #include <iostream>
+#include <vector>
 #include "datamodel/Serializable.h"
 
 namespace sequencemodel {
@@ -22,6 +23,23 @@ namespace sequencemodel {
 		virtual _string generate_sequence (size_t length) = 0;
 
 		virtual void dump (std::ostream & str) = 0;
+
+		/**
+		 * Get the transition probabilities of the model for computing
+		 * exact distributions.
+		 *
+		 * Contexts are the last order characters, with the most recent
+		 * one as the most significant digit in base alphabet.
+		 *
+		 * @param order    : receives the number of context characters
+		 * @param alphabet : receives the alphabet size
+		 * @param probs    : receives P(c | context) at context * alphabet + c
+		 *
+		 * @return false if the model cannot give these
+		 */
+		virtual bool get_transition_probabilities (int & order, size_t & alphabet, std::vector<double> & probs) const {
+			return false;
+		}
 	};
 };
 
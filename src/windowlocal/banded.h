@@ -0,0 +1,183 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __WL_BANDED_H__
+#define __WL_BANDED_H__
+
+#include "autoconfig.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "xasmlib/IntegerVector.h"
+#include "lcs/LlcsCIPR.h"
+#include "report.h"
+
+namespace windowlocal {
+
+/**
+ * \brief Banded window-local LCS along one diagonal of an alignment plot.
+ *
+ * x and y are aligned on the diagonal, window pair i is
+ * x[i ... i+w-1] vs. y[i ... i+w-1]. Characters x[r] and y[c] may only
+ * be matched if |c - r| <= band.
+ *
+ * Matches outside the band are impossible, so an optimal path can
+ * always be moved into the band, and crosses row K of the grid close to
+ * the diagonal. For K a multiple of w, every window pair i with
+ * K - w <= i < K therefore has
+ *
+ *   LCS(i) = max_d  LCS(x[i..K), y[i..K+d)) + LCS(x[K..i+w), y[K+d..i+w))
+ *
+ * with |d| <= band + 1. Both terms are computed for all i in the block
+ * and all d with one CIPR word per d. Each word only holds the 2*band+1
+ * columns inside the band. Columns which leave the band cannot change
+ * anymore, and the number of matched columns among them is kept in a
+ * counter. The cost is O(band) per window pair instead of O(w).
+ */
+template < int _bpc >
+class BandedWindowLocalLCS {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	enum {
+		max_band = 31,
+	};
+
+	BandedWindowLocalLCS(int _window, int _band)
+		: window(_window), band(_band) {
+		ASSERT(band >= 0 && band <= max_band);
+	}
+
+	/**
+	 * count full matches of all window pairs along the diagonal,
+	 * report banded window lcs lengths.
+	 *
+	 * Window pair i is reported at x0 = i + y_p0, x1 = i + x_p0.
+	 */
+	int count(string const & x, string const & y,
+		window_reporter * rpt = NULL,
+		int x_p0 = 0,
+		int y_p0 = 0
+		) {
+		int L = (int)std::min(x.size(), y.size());
+		if (L < window) {
+			return 0;
+		}
+		int nd = 2*band + 3;
+		int count = 0;
+
+		string xr = x.substr(0, L), yr = y.substr(0, L);
+		xr.reverse();
+		yr.reverse();
+
+		for (int K = window; K <= L; K += window) {
+			int i1 = std::min(K, L - window + 1);
+			block(x, y, K, std::min(window, L - K), forward);
+			block(xr, yr, L - K, window, backward);
+
+			for (int i = K - window; i < i1; ++i) {
+				const int * a = &backward[(K - i)*nd];
+				const int * b = &forward[(i + window - K)*nd];
+				int lcslen = 0;
+				for (int d = 0; d < nd; ++d) {
+					// in the reversed strings, d is mirrored
+					int ad = a[nd - 1 - d];
+					if (ad >= 0 && b[d] >= 0) {
+						lcslen = std::max(lcslen, ad + b[d]);
+					}
+				}
+
+				if(rpt != NULL) {
+					rpt->report_score(windowlocal::window(i + y_p0, i + x_p0, (double)lcslen));
+				}
+				if(lcslen == window) {
+					++count;
+				}
+			}
+		}
+		return count;
+	}
+
+	/* set the window length */
+	void set_windowlength(int _windowlength) {
+		window = _windowlength;
+	}
+
+	/* set the band width */
+	void set_band(int _band) {
+		ASSERT(_band >= 0 && _band <= max_band);
+		band = _band;
+	}
+
+private:
+	/**
+	 * \brief banded LCS from the cut at row K
+	 *
+	 * out[q*nd + d + band + 1] receives LCS(x[K..K+q), y[K+d..K+q)) for
+	 * q = 0 ... rows and |d| <= band + 1, or -1 if K + d > K + q.
+	 */
+	void block(string const & x, string const & y, int K, int rows, std::vector<int> & out) {
+		int nd = 2*band + 3;
+		int yl = (int)y.size();
+		out.resize((window + 1)*nd);
+		words.assign(nd, ~((UINT64)0));
+		frozen.assign(nd, 0);
+
+		UINT64 low = (((UINT64)1) << band) - 1;
+		for (int q = 0; q <= rows; ++q) {
+			int r = K + q;
+			int lo = r - band; // column of bit 0
+
+			for (int d = 0; d < nd; ++d) {
+				int s = K + d - band - 1;
+				if (s > r) {
+					out[q*nd + d] = -1;
+					continue;
+				}
+				int rel = s - lo;
+				UINT64 m = (rel > 0) ? (low & (~((UINT64)0) << rel)) : low;
+				out[q*nd + d] = frozen[d] + (int)lcs::popcount64(~words[d] & m);
+			}
+			if (q == rows) {
+				break;
+			}
+
+			// match mask for x[r] inside the band
+			UINT64 base = 0;
+			int xc = x.get(r);
+			for (int t = 0; t <= 2*band; ++t) {
+				int c = lo + t;
+				if (c >= 0 && c < yl && (int)y.get(c) == xc) {
+					base |= ((UINT64)1) << t;
+				}
+			}
+
+			for (int d = 0; d < nd; ++d) {
+				int rel = K + d - band - 1 - lo;
+				UINT64 m = (rel <= 0) ? base : (rel >= 64 ? 0 : base & (~((UINT64)0) << rel));
+				UINT64 l = words[d];
+				l = (l + (l & m)) | (l & ~m);
+				// column lo leaves the band, a new column enters on top
+				if ((l & 1) == 0) {
+					++frozen[d];
+				}
+				words[d] = (l >> 1) | (~((UINT64)0) << (2*band));
+			}
+		}
+	}
+
+	int window;
+	int band;
+
+	std::vector<UINT64> words; ///< CIPR words for each d
+	std::vector<int> frozen; ///< matched columns left of the band for each d
+	std::vector<int> forward; ///< LCS values from the cut downwards
+	std::vector<int> backward; ///< LCS values from the cut upwards
+};
+
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "lcs/LlcsCIPR.h"
 
 #include "report.h"
+#include "composition_bound.h"
 
 namespace windowlocal {
 
@@ -40,22 +41,39 @@ public:
 	static const UINT64 lsbs = ( msb-1 );
 
    	BoassonMPRAMMatcher(size_t _window, string const & _pattern) 
-		: window(_window) {
-		using namespace std;
+		: window(_window), patsize(0) {
 		// ASSERT(log2(_window+2) <= _omega);
-		const int alphasize = static_cast<UINT64>(1) << _bpc;
+		set_pattern(_pattern);
+	}
 
-#ifdef _VERBOSETEST_WINDOWLCS_BOASSON
+	/** 
+	 * set the pattern 
+	 * 
+	 * The mappings and the state vectors are kept between patterns. 
+	 * If the pattern length does not change, only the entries of the 
+	 * previous pattern are reset.
+	 */
+	void set_pattern(string const & _pattern) {
+		if (_pattern.size() != patsize) {
+			patsize = _pattern.size();
+			for(int j = 0; j < alphasize; ++j) {
+				patternmapping_M[j].resize(patsize);
+				patternmapping_N[j].resize(patsize);
+				patternmapping_M[j].zero();
+				patternmapping_N[j].one();
+			}
+			L.resize(patsize);
+			T.resize(patsize);
+		} else {
+			for(size_t j = 1; j < patsize; ++j) {
+				patternmapping_M[(size_t)pattern[j]][j-1] = 0;
+			}
+			for(size_t j = 0; j < patsize; ++j) {
+				patternmapping_N[(size_t)pattern[j]][j] = lsbs;
+			}
+		}
 		pattern = _pattern;
-#endif /* _VERBOSETEST_WINDOWLCS_BOASSON */
-		patsize = _pattern.size();
 
-		for(int j = 0; j < alphasize; ++j) {
-			patternmapping_M[j].resize(patsize);
-			patternmapping_N[j].resize(patsize);
-			patternmapping_M[j].zero();
-			patternmapping_N[j].one();
-		}
 		for(size_t j = 1; j < patsize; ++j) {
 			patternmapping_M[(size_t)_pattern[j]][j-1] = lsbs;
 		}
@@ -63,11 +81,37 @@ public:
 			patternmapping_N[(size_t)_pattern[j]][j] = 0;
 		}
 
-
 		p1 = _pattern[0];
+		bound.set_pattern(_pattern);
+	}
+
+	/* set the window length */ 
+	void set_windowlength(int _windowlength) {
+		window = _windowlength;
 	}
 
+	/**
+	 * count matches of pattern in text, report window lcs lengths
+	 *
+	 * Text blocks in which no window can reach the reporter's score
+	 * threshold are skipped. The matcher state only depends on the last
+	 * window characters, so restarting it a window length before the
+	 * next block gives the same scores as running it on the whole text.
+	 */
 	int count(string const & text, 
+		window_reporter * rpt = NULL, 
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		if (rpt == NULL || rpt->score_threshold() == -DBL_MAX) {
+			return count_all(text, rpt, text_p0, pat_p0);
+		}
+		return count_above_threshold(*this, bound, text, (int)window,
+			rpt, text_p0, pat_p0, (int)window);
+	}
+
+	/** count matches and report scores for all windows */
+	int count_all(string const & text, 
 		window_reporter * rpt = NULL, 
 		int text_p0 = 0,
 		int pat_p0 = 0
@@ -75,11 +119,9 @@ public:
 		using namespace std;
 		size_t count = 0;
 
-		STATE_TYPE L(patsize);
 		L.zero();
 		L.set_bits(lsbs);
 
-		STATE_TYPE T(patsize);
 		UINT64 alpha;
 		UINT64 delta = lsbs-1-window;
 		size_t n = text.size();
@@ -178,14 +220,20 @@ public:
     }
 
 private:
+	enum {
+		alphasize = (1 << _bpc),
+	};
+
 	size_t window;
 	size_t patsize;
+	string pattern;
+	QGramBound<_bpc> bound; ///< upper bound for skipping text blocks
 	STATE_TYPE patternmapping_M[(static_cast<UINT64>(1) << _bpc)+1];
 	STATE_TYPE patternmapping_N[(static_cast<UINT64>(1) << _bpc)+1];
 
-#ifdef _VERBOSETEST_WINDOWLCS_BOASSON
-	string pattern;
-#endif /* _VERBOSETEST_WINDOWLCS_BOASSON */
+	/** matcher state, kept here to avoid mallocs */
+	STATE_TYPE L;
+	STATE_TYPE T;
 
 	UINT64 p1;
 };
@@ -0,0 +1,260 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __WL_COMPOSITION_BOUND_H__
+#define __WL_COMPOSITION_BOUND_H__
+
+#include <vector>
+
+#include "xasmlib/IntegerVector.h"
+#include "report.h"
+
+namespace windowlocal {
+
+/**
+ * \brief Character composition upper bound for window-local LCS.
+ *
+ * Every character of an LCS occurs in both strings, so
+ *
+ *   LLCS(p, w) <= sum_c min( #c in p, #c in w ).
+ *
+ * When moving the window by one character, the bound changes by at
+ * most one and can be updated in constant time.
+ */
+template < int _bpc >
+class CompositionBound {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	enum {
+		alphasize = (1 << _bpc),
+	};
+
+	CompositionBound() : pattern_count(alphasize, 0), window_count(alphasize, 0), bound(0) {}
+
+	/** set the pattern to count characters in */
+	void set_pattern(string const & pattern) {
+		std::fill(pattern_count.begin(), pattern_count.end(), 0);
+		for (size_t j = 0; j < pattern.size(); ++j) {
+			++pattern_count[pattern.get(j)];
+		}
+	}
+
+	/** start with an empty window */
+	void clear() {
+		std::fill(window_count.begin(), window_count.end(), 0);
+		bound = 0;
+	}
+
+	/** add a character to the window */
+	void add(int c) {
+		if (window_count[c]++ < pattern_count[c]) {
+			++bound;
+		}
+	}
+
+	/** remove a character from the window */
+	void remove(int c) {
+		if (--window_count[c] < pattern_count[c]) {
+			--bound;
+		}
+	}
+
+	/** the bound for the current window */
+	int get() const {
+		return bound;
+	}
+
+	/**
+	 * \brief compute the bounds for all windows of a text
+	 *
+	 * bounds[j] receives the bound for text[j ... j + window - 1]
+	 */
+	void window_bounds(string const & text, int window, std::vector<int> & bounds) {
+		int n = (int)text.size() - window + 1;
+		bounds.resize(n > 0 ? n : 0);
+		clear();
+		for (int j = 0; j < window - 1 && j < (int)text.size(); ++j) {
+			add(text.get(j));
+		}
+		for (int j = 0; j < n; ++j) {
+			add(text.get(j + window - 1));
+			bounds[j] = bound;
+			remove(text.get(j));
+		}
+	}
+
+private:
+	std::vector<int> pattern_count;
+	std::vector<int> window_count;
+	int bound;
+};
+
+/**
+ * \brief q-gram upper bound for window-local LCS.
+ *
+ * Let Q be the number of q-grams which p and w share (counted with
+ * multiplicity), and L = LLCS(p, w). Each q-gram of p which is
+ * preserved in an optimal alignment occurs in w. A character of p
+ * which is not in the LCS destroys at most q q-grams of p, a character
+ * of w which is not in the LCS at most q - 1, so
+ *
+ *   |p| - q + 1 - Q <= q (|p| - L) + (q - 1) (|w| - L)
+ *
+ * For q = 1, this is the composition bound. q-grams are hashed into
+ * 2^_hashbits buckets, collisions can only make the bound weaker.
+ *
+ * window_bounds gives the minimum of this and the composition bound.
+ * On random DNA with |p| = |w| = 100, both bounds are around 0.9 |w|,
+ * so they only skip windows at high thresholds. They are effective on
+ * low complexity sequence and unrelated regions with a different
+ * composition.
+ */
+template < int _bpc, int _q = 4, int _hashbits = 12 >
+class QGramBound {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	enum {
+		q = _q,
+		buckets = (1 << _hashbits),
+	};
+
+	QGramBound() : pattern_count(buckets, 0), window_count(buckets, 0), plen(0) {}
+
+	/** set the pattern to count q-grams in */
+	void set_pattern(string const & pattern) {
+		composition.set_pattern(pattern);
+		plen = (int)pattern.size();
+		std::fill(pattern_count.begin(), pattern_count.end(), 0);
+		UINT64 g = 0;
+		for (int j = 0; j < plen; ++j) {
+			g = (g << _bpc) | pattern.get(j);
+			if (j >= _q - 1) {
+				++pattern_count[bucket(g)];
+			}
+		}
+	}
+
+	/**
+	 * \brief compute the bounds for all windows of a text
+	 *
+	 * bounds[j] receives the bound for text[j ... j + window - 1]
+	 */
+	void window_bounds(string const & text, int window, std::vector<int> & bounds) {
+		composition.window_bounds(text, window, bounds);
+		int n = (int)bounds.size();
+		if (n == 0 || window < _q || plen < _q) {
+			return;
+		}
+
+		// q-gram j starts at text position j
+		int ng = (int)text.size() - _q + 1;
+		grams.resize(ng);
+		UINT64 g = 0;
+		for (int j = 0; j < (int)text.size(); ++j) {
+			g = (g << _bpc) | text.get(j);
+			if (j >= _q - 1) {
+				grams[j - _q + 1] = bucket(g);
+			}
+		}
+
+		std::fill(window_count.begin(), window_count.end(), 0);
+		const int wg = window - _q + 1;
+		const int base = _q * plen + (_q - 1) * window - plen + _q - 1;
+		int shared = 0;
+		for (int j = 0; j < wg - 1; ++j) {
+			if (window_count[grams[j]]++ < pattern_count[grams[j]]) {
+				++shared;
+			}
+		}
+		for (int j = 0; j < n; ++j) {
+			int a = grams[j + wg - 1];
+			if (window_count[a]++ < pattern_count[a]) {
+				++shared;
+			}
+			int b = (base + shared) / (2*_q - 1);
+			if (b < bounds[j]) {
+				bounds[j] = b;
+			}
+			int r = grams[j];
+			if (--window_count[r] < pattern_count[r]) {
+				--shared;
+			}
+		}
+	}
+
+private:
+	static int bucket(UINT64 g) {
+		g &= (_q * _bpc >= 64) ? (UINT64)-1 : ((((UINT64)1) << ((_q * _bpc) & 63)) - 1);
+		return (int)((g * 0x9E3779B97F4A7C15ULL) >> (64 - _hashbits));
+	}
+
+	CompositionBound<_bpc> composition;
+	std::vector<int> pattern_count;
+	std::vector<int> window_count;
+	std::vector<int> grams;
+	int plen;
+};
+
+/**
+ * \brief Run a streaming window-local matcher only on the text blocks
+ *        which contain windows that can reach the reporter's threshold.
+ *
+ * The matcher must provide count_all(text, rpt, text_p0, pat_p0),
+ * which computes and reports all windows of the text it is given.
+ * Windows whose bound is below the threshold are skipped,
+ * gaps of fewer than min_gap such windows are computed anyway, since
+ * restarting the matcher has a cost. Only windows at multiples of
+ * grid_size are considered.
+ *
+ * \return the number of full matches in the blocks that were computed
+ */
+template < class _matcher, class _bound >
+int count_above_threshold(
+	_matcher & m,
+	_bound & b,
+	typename _bound::string const & text,
+	int window,
+	window_reporter * rpt,
+	int text_p0,
+	int pat_p0,
+	int min_gap,
+	int grid_size = 1
+	) {
+	std::vector<int> bounds;
+	b.window_bounds(text, window, bounds);
+
+	int n = (int)bounds.size();
+	int count = 0;
+	int j = 0;
+	while (j < n) {
+		// the threshold can only grow while we report windows
+		double threshold = rpt->score_threshold();
+		while (j < n && (j % grid_size != 0 || bounds[j] < threshold)) {
+			++j;
+		}
+		if (j >= n) {
+			break;
+		}
+
+		int start = j;
+		int last = j;
+		for (int k = j + 1; k < n && k - last <= min_gap; ++k) {
+			if (k % grid_size == 0 && bounds[k] >= threshold) {
+				last = k;
+			}
+		}
+
+		count += m.count_all(text.substr(start, last - start + window),
+			rpt, text_p0 + start, pat_p0);
+		j = last + 1;
+	}
+	return count;
+}
+
+};
+
+#endif
@@ -0,0 +1,366 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __WL_KMER_FILTER_H__
+#define __WL_KMER_FILTER_H__
+
+#include "autoconfig.h"
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+
+#include "xasmlib/IntegerVector.h"
+
+namespace windowlocal {
+
+/**
+ * \brief Hashed k-mer index over a text.
+ *
+ * k-mers are hashed with a rolling polynomial hash into 2^hash_bits
+ * buckets, and the start positions for each bucket are stored
+ * contiguously. Hash collisions only add spurious positions, so a
+ * lookup returns a superset of the occurrences of a k-mer.
+ */
+template < int _bpc >
+class KmerIndex {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	KmerIndex(int _k = 8, int _hash_bits = 20)
+		: k(_k), hash_bits(_hash_bits), power(1) {
+		for (int j = 1; j < k; ++j) {
+			power *= base;
+		}
+	}
+
+	/** index all k-mers of text */
+	void build(string const & text) {
+		int n = (int)text.size() - k + 1;
+		bucket_start.assign((((size_t)1) << hash_bits) + 1, 0);
+		positions.resize(n > 0 ? n : 0);
+		if (n <= 0) {
+			return;
+		}
+
+		std::vector<unsigned int> buckets(n);
+		UINT64 h = first(text, 0);
+		for (int j = 0; j < n; ++j) {
+			if (j > 0) {
+				h = roll(h, text.get(j - 1), text.get(j + k - 1));
+			}
+			buckets[j] = bucket(h);
+			++bucket_start[buckets[j] + 1];
+		}
+		for (size_t b = 1; b < bucket_start.size(); ++b) {
+			bucket_start[b] += bucket_start[b - 1];
+		}
+		std::vector<int> fill(bucket_start.begin(), bucket_start.end() - 1);
+		for (int j = 0; j < n; ++j) {
+			positions[fill[buckets[j]]++] = j;
+		}
+	}
+
+	/** hash of the k-mer starting at s[pos] */
+	UINT64 first(string const & s, size_t pos) const {
+		UINT64 h = 0;
+		for (int j = 0; j < k; ++j) {
+			h = h * base + (UINT64)s.get(pos + j) + 1;
+		}
+		return h;
+	}
+
+	/** move the hash one character to the right */
+	UINT64 roll(UINT64 h, int c_out, int c_in) const {
+		return (h - ((UINT64)c_out + 1) * power) * base + (UINT64)c_in + 1;
+	}
+
+	/** get the positions for the bucket of hash h */
+	void lookup(UINT64 h, const int * & begin, const int * & end) const {
+		unsigned int b = bucket(h);
+		begin = positions.empty() ? NULL : &positions[0] + bucket_start[b];
+		end = positions.empty() ? NULL : &positions[0] + bucket_start[b + 1];
+	}
+
+	int get_k() const {
+		return k;
+	}
+
+private:
+	static const UINT64 base = 0x100000001b3ULL;
+
+	unsigned int bucket(UINT64 h) const {
+		return (unsigned int)((h * 0x9e3779b97f4a7c15ULL) >> (64 - hash_bits));
+	}
+
+	int k;
+	int hash_bits;
+	UINT64 power; ///< base^(k-1)
+	std::vector<int> bucket_start;
+	std::vector<int> positions;
+};
+
+/**
+ * \brief q-gram filter for window pairs with high LCS.
+ *
+ * If two windows of length w have LCS at least L, e = w - L characters
+ * in each window are not matched. Each unmatched character of the first
+ * window destroys at most k of its k-mers, each unmatched character of
+ * the second window splits at most k - 1 of them, so at least
+ *
+ *   T = (w - k + 1) - (2k - 1) * e
+ *
+ * k-mers occur unchanged in the second window, shifted by at most e
+ * diagonals from the diagonal of the window pair.
+ *
+ * For each window in x, we count the hits of its k-mers in diagonal
+ * buckets of width 2e + 1. The diagonals of the T hits for a matching
+ * window pair fall into two adjacent buckets, so we only need to look
+ * at windows in y around bucket pairs with at least T hits. The counts
+ * are updated incrementally when moving to the next window in x.
+ *
+ * Smaller k give larger T, but also more random hits. k is chosen to
+ * minimise the probability that a bucket pair in unrelated sequences
+ * reaches T hits, assuming the number of hits is Poisson distributed.
+ */
+template < int _bpc >
+class KmerFilter {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+	typedef std::pair<int, int> range;
+
+	/**
+	 * \param y the text to search in
+	 * \param _window the window length
+	 * \param min_lcs minimum LCS for window pairs which must be found
+	 * \param k k-mer length, 0 to choose automatically
+	 */
+	KmerFilter(string const & y, int _window, int min_lcs, int k = 0, int hash_bits = 20)
+		: window(_window), ny((int)y.size()), 
+		  index(choose_k(y, _window, min_lcs, k), hash_bits) {
+		e = std::max(0, window - min_lcs);
+		width = 2*e + 1;
+		min_hits = (window - index.get_k() + 1) - (2*index.get_k() - 1) * e;
+		if (enabled()) {
+			index.build(y);
+		}
+	}
+
+	/** false if the threshold is too low for the filter to work */
+	bool enabled() const {
+		return min_hits > 0;
+	}
+
+	int get_k() const {
+		return index.get_k();
+	}
+
+	/** the minimum number of k-mer hits for a window pair */
+	int get_min_hits() const {
+		return min_hits;
+	}
+
+	/**
+	 * \brief find candidate windows in y for the windows x[i0 ... i0 + count - 1]
+	 *
+	 * \param ranges ranges[i - i0] receives sorted, disjoint ranges 
+	 *        [first, second] of window start positions in y for window i
+	 *        in x. Every window pair with LCS at least min_lcs has its y 
+	 *        window in one of these.
+	 */
+	void candidates(string const & x, int i0, int count, 
+		std::vector< std::vector<range> > & ranges) {
+		ranges.resize(count);
+		for (int i = 0; i < count; ++i) {
+			ranges[i].clear();
+		}
+		int k = index.get_k();
+		count = std::min(count, (int)x.size() - window + 1 - i0);
+		if (!enabled() || count <= 0) {
+			return;
+		}
+
+		// diagonals b - a range from -|x| to |y|, shift to make bucket indices positive
+		shift = (int)x.size() + width;
+		hits.resize((ny + shift) / width + 2, 0);
+		open.resize(hits.size(), -1);
+
+		// k-mers of window i start at i ... i + window - k
+		UINT64 h_out = index.first(x, i0);
+		UINT64 h_in = h_out;
+		for (int a = i0; a <= i0 + window - k; ++a) {
+			if (a > i0) {
+				h_in = index.roll(h_in, x.get(a - 1), x.get(a + k - 1));
+			}
+			add_hits(h_in, a, 1);
+		}
+		update_open(i0, i0, ranges);
+
+		for (int i = i0 + 1; i < i0 + count; ++i) {
+			add_hits(h_out, i - 1, -1);
+			h_out = index.roll(h_out, x.get(i - 1), x.get(i + k - 1));
+			int a = i + window - k;
+			h_in = index.roll(h_in, x.get(a - 1), x.get(a + k - 1));
+			add_hits(h_in, a, 1);
+			update_open(i, i0, ranges);
+		}
+
+		for (size_t t = 0; t < touched.size(); ++t) {
+			int b = touched[t];
+			if (open[b] >= 0) {
+				emit(b, open[b], i0 + count - 1, i0, ranges);
+				open[b] = -1;
+			}
+			hits[b] = 0;
+		}
+		touched.clear();
+		changed.clear();
+
+		for (int i = 0; i < count; ++i) {
+			merge_ranges(ranges[i]);
+		}
+	}
+
+private:
+	/** 
+	 * choose k to minimise the probability of random candidates 
+	 * 
+	 * The probability that two characters match is estimated from the 
+	 * composition of y.
+	 */
+	static int choose_k(string const & y, int window, int min_lcs, int k) {
+		if (k > 0) {
+			return k;
+		}
+		std::vector<double> freq(1 << _bpc, 0.0);
+		for (size_t j = 0; j < y.size(); ++j) {
+			freq[y.get(j)] += 1.0;
+		}
+		double p_match = 0;
+		for (size_t c = 0; c < freq.size(); ++c) {
+			p_match += (freq[c] / std::max((double)y.size(), 1.0)) 
+			         * (freq[c] / std::max((double)y.size(), 1.0));
+		}
+
+		int e = std::max(0, window - min_lcs);
+		int best_k = 3;
+		double best_p = 2.0;
+		double p_kmer = p_match * p_match;
+		for (int kk = 3; kk <= 16 && kk <= window; ++kk) {
+			p_kmer *= p_match;
+			int t = (window - kk + 1) - (2*kk - 1) * e;
+			if (t <= 0) {
+				break;
+			}
+			// expected hits of a window in a bucket pair
+			double lambda = (window - kk + 1) * 2.0 * (2*e + 1) * p_kmer;
+			double p = poisson_tail(lambda, t);
+			if (p <= best_p) {
+				best_p = p;
+				best_k = kk;
+			}
+		}
+		return best_k;
+	}
+
+	/** P(X >= t) for X ~ Poisson(lambda) */
+	static double poisson_tail(double lambda, int t) {
+		double term = exp(-lambda);
+		double below = 0;
+		for (int j = 0; j < t; ++j) {
+			below += term;
+			term *= lambda / (j + 1);
+		}
+		return std::max(0.0, 1.0 - below);
+	}
+
+	/** add or remove the hits of the k-mer with hash h at x position a */
+	void add_hits(UINT64 h, int a, int delta) {
+		const int * begin, * end;
+		index.lookup(h, begin, end);
+		for (const int * b = begin; b != end; ++b) {
+			int bucket = (*b - a + shift) / width;
+			if (hits[bucket] == 0) {
+				touched.push_back(bucket);
+			}
+			hits[bucket] += delta;
+			changed.push_back(bucket);
+		}
+	}
+
+	/** 
+	 * update the bucket pairs which have enough hits after 
+	 * moving to window i
+	 *
+	 * open[b] is the first window for which pair (b, b + 1) has had 
+	 * enough hits, or -1.
+	 */
+	void update_open(int i, int i0, std::vector< std::vector<range> > & ranges) {
+		for (size_t t = 0; t < changed.size(); ++t) {
+			for (int b0 = changed[t] - 1; b0 <= changed[t]; ++b0) {
+				if (b0 < 0) {
+					continue;
+				}
+				bool enough = hits[b0] + hits[b0 + 1] >= min_hits;
+				if (enough && open[b0] < 0) {
+					touched.push_back(b0);
+					open[b0] = i;
+				} else if (!enough && open[b0] >= 0) {
+					emit(b0, open[b0], i - 1, i0, ranges);
+					open[b0] = -1;
+				}
+			}
+		}
+		changed.clear();
+	}
+
+	/** add the y windows for bucket pair (b0, b0 + 1) to the ranges of windows i_begin ... i_end */
+	void emit(int b0, int i_begin, int i_end, int i0, std::vector< std::vector<range> > & ranges) {
+		// diagonals d with [d - e, d + e] inside buckets b0, b0 + 1
+		int d0 = b0 * width + e - shift;
+		int d1 = (b0 + 1) * width + e - shift;
+		for (int i = i_begin; i <= i_end; ++i) {
+			int j0 = std::max(0, i + d0);
+			int j1 = std::min(ny - window, i + d1);
+			if (j0 <= j1) {
+				ranges[i - i0].push_back(range(j0, j1));
+			}
+		}
+	}
+
+	/** sort ranges and merge overlapping and adjacent ones */
+	static void merge_ranges(std::vector<range> & r) {
+		if (r.size() < 2) {
+			return;
+		}
+		std::sort(r.begin(), r.end());
+		size_t m = 0;
+		for (size_t j = 1; j < r.size(); ++j) {
+			if (r[m].second + 1 >= r[j].first) {
+				r[m].second = std::max(r[m].second, r[j].second);
+			} else {
+				r[++m] = r[j];
+			}
+		}
+		r.resize(m + 1);
+	}
+
+	int window;
+	int ny;
+	int e; ///< maximum number of unmatched characters
+	int width; ///< diagonal bucket width
+	int min_hits; ///< q-gram lemma threshold
+	int shift; ///< diagonal offset for bucket indices
+	KmerIndex<_bpc> index;
+	std::vector<int> hits; ///< hit counts per diagonal bucket
+	std::vector<int> open; ///< first window with enough hits per bucket pair
+	std::vector<int> touched; ///< buckets which need to be reset, may contain duplicates
+	std::vector<int> changed; ///< buckets changed in the last update
+};
+
+};
+
+#endif
@@ -0,0 +1,154 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __WL_MULTI_CIPR_H__
+#define __WL_MULTI_CIPR_H__
+
+#include <algorithm>
+#include <vector>
+
+#include "xasmlib/IntegerVector.h"
+#include "lcs/LlcsCIPR.h"
+#include "report.h"
+#include "composition_bound.h"
+
+namespace windowlocal {
+
+/**
+ * \brief Bit-parallel window-local LCS for several patterns at once.
+ *
+ * Each pattern has at most 64 characters, so its CIPR row fits into a
+ * single machine word. The rows for up to _lanes patterns are updated
+ * together for every text character. The lane loops have a fixed
+ * length and no dependencies, so the compiler can map them to SIMD
+ * registers.
+ *
+ * Scores for pattern k are reported with pattern position pat_p0 + k.
+ *
+ * Like BPWindowLocalLCS, windows are skipped when no pattern can reach
+ * the reporter's score threshold.
+ */
+template < int _bpc, int _lanes = 4 >
+class MultiBPWindowLocalLCS {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	enum {
+		lanes = _lanes,
+		max_patternlength = 64,
+		alphasize = (1 << _bpc),
+	};
+
+	MultiBPWindowLocalLCS(int _window)
+		: window(_window), n_patterns(0), masks(alphasize*_lanes, 0) {
+		for (int k = 0; k < _lanes; ++k) {
+			lengths[k] = 0;
+		}
+	}
+
+	/**
+	 * set up to _lanes patterns of at most 64 characters each
+	 */
+	void set_patterns(string const * patterns, int count) {
+		ASSERT(count <= _lanes);
+		n_patterns = count;
+		std::fill(masks.begin(), masks.end(), 0);
+		for (int k = 0; k < _lanes; ++k) {
+			lengths[k] = 0;
+		}
+		for (int k = 0; k < count; ++k) {
+			ASSERT(patterns[k].size() <= max_patternlength);
+			lengths[k] = (int)patterns[k].size();
+			for (int j = 0; j < lengths[k]; ++j) {
+				masks[patterns[k].get(j)*_lanes + k] |= ((UINT64)1) << j;
+			}
+			bound[k].set_pattern(patterns[k]);
+		}
+	}
+
+	/** count matches of all patterns in text, report window lcs lengths */
+	int count(string const & text,
+		window_reporter * rpt = NULL,
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		ASSERT(text.size() >= window);
+		int n = (int)(text.size() - window + 1);
+		int count = 0;
+
+		bool have_bounds = false;
+		int last_j[_lanes], last_score[_lanes];
+		for (int k = 0; k < _lanes; ++k) {
+			last_j[k] = 0;
+			last_score[k] = window;
+		}
+
+		for(int j = 0; j < n; j+= 1) {
+			if (rpt != NULL) {
+				double threshold = rpt->score_threshold();
+				if (threshold > -DBL_MAX) {
+					if (!have_bounds) {
+						for (int k = 0; k < n_patterns; ++k) {
+							bound[k].window_bounds(text, window, bounds[k]);
+						}
+						have_bounds = true;
+					}
+					bool skip = true;
+					for (int k = 0; k < n_patterns; ++k) {
+						if (std::min(bounds[k][j], last_score[k] + j - last_j[k]) >= threshold) {
+							skip = false;
+						}
+					}
+					if (skip) {
+						continue;
+					}
+				}
+			}
+
+			UINT64 r[_lanes];
+			for (int k = 0; k < _lanes; ++k) {
+				r[k] = (UINT64)-1;
+			}
+			for (int c = j; c < j + window; ++c) {
+				const UINT64 * m = &masks[text.get(c)*_lanes];
+				for (int k = 0; k < _lanes; ++k) {
+					UINT64 l = r[k];
+					r[k] = (l + (l & m[k])) | (l & ~m[k]);
+				}
+			}
+
+			for (int k = 0; k < n_patterns; ++k) {
+				int lcslen = 64 - (int)lcs::popcount64(r[k]);
+				if(rpt != NULL) {
+					rpt->report_score(windowlocal::window(j+text_p0, pat_p0 + k, (double)lcslen));
+				}
+				last_j[k] = j;
+				last_score[k] = lcslen;
+				if(lcslen == lengths[k]) {
+					++count;
+				}
+			}
+		}
+
+		return count;
+	}
+
+	/* set the window length */
+	void set_windowlength(int _windowlength) {
+		window = _windowlength;
+	}
+
+private:
+	int window;
+	int n_patterns;
+	int lengths[_lanes]; ///< pattern lengths
+	std::vector<UINT64> masks; ///< match masks, masks[c*_lanes + k] for character c in pattern k
+	QGramBound<_bpc> bound[_lanes]; ///< upper bounds for skipping windows
+	std::vector<int> bounds[_lanes]; ///< bounds for the current text
+};
+
+};
+
+#endif
@@ -6,9 +6,15 @@
 #ifndef __WL_NAIVE_CIPR_H__
 #define __WL_NAIVE_CIPR_H__
 
+#include <algorithm>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
 #include "xasmlib/IntegerVector.h"
 #include "lcs/LlcsCIPR.h"
 #include "report.h"
+#include "composition_bound.h"
 
 namespace windowlocal {
 
@@ -18,11 +24,22 @@ public:
 	typedef utilities::IntegerVector<_bpc> string; 
 
 	BPWindowLocalLCS(int _window, string const & _pattern) 
-		: window(_window), 
-		  pattern(_pattern) {
+		: window(_window) {
+		set_pattern(_pattern);
 	}
 
-	/** count matches of pattern in text, report windowlength-lcs lengths */
+	/** 
+	 * count matches of pattern in text, report windowlength-lcs lengths 
+	 * 
+	 * The windows are read from the text in place, the pattern mapping 
+	 * and the row bit string are kept between calls.
+	 * 
+	 * Windows which cannot reach the reporter's score threshold are
+	 * skipped, they are neither reported nor counted. Moving the window
+	 * by one character increases its LCS by at most one, so after a
+	 * window with score s was computed, the window k steps further has
+	 * a score of at most s + k. This is combined with the q-gram bound.
+	 */
 	int count(string const & text, 
 		window_reporter * rpt = NULL, 
 		int text_p0 = 0,
@@ -32,6 +49,60 @@ public:
 		int n = (int)(text.size() - window + 1), 
 		 	p = pattern.size();
 		int count = 0;
+
+		bool have_bounds = false;
+		int last_j = 0, last_score = window;
+
+		for(int j = 0; j < n; j+= 1) {
+			if (rpt != NULL) {
+				double threshold = rpt->score_threshold();
+				if (threshold > -DBL_MAX) {
+					// the threshold is only set once the reporter
+					// has seen enough windows
+					if (!have_bounds) {
+						bound.window_bounds(text, window, bounds);
+						have_bounds = true;
+					}
+					if (std::min(bounds[j], last_score + j - last_j) < threshold) {
+						continue;
+					}
+				}
+			}
+
+			int lcslen = (int)llcs(p, *pattern_mapping, text, j, window, row);
+
+#ifdef _VERBOSETEST_WINDOWLCS_CIPR
+			cout << "window " << j << "..." << j+window  << ":  LCS =  " << lcslen << endl;
+#endif // _VERBOSETEST_WINDOWLCS_CIPR
+
+			if(rpt != NULL) {
+				rpt->report_score(windowlocal::window(j+text_p0, pat_p0, (double)lcslen));
+			}
+
+			last_j = j;
+			last_score = lcslen;
+
+			if(lcslen == p) {
+				++count;
+			}
+		}
+
+		return count;
+	}
+
+	/** 
+	 * Reference implementation of count, which copies each window and 
+	 * computes its LCS from scratch.
+	 */
+	int count_naive(string const & text, 
+		window_reporter * rpt = NULL, 
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		ASSERT(text.size() >= window);
+		int n = (int)(text.size() - window + 1), 
+		 	p = pattern.size();
+		int count = 0;
 		static lcs::LlcsCIPR<_bpc> llcs;
 
 		utilities::CharMapping<_bpc, 1, false> 
@@ -66,6 +137,10 @@ public:
 	/** set the pattern */
 	void set_pattern(string _pattern) {
 		pattern = _pattern;
+		pattern_mapping = boost::shared_ptr< utilities::CharMapping<_bpc, 1, false> > (
+			new utilities::CharMapping<_bpc, 1, false> (pattern) );
+		row.resize(pattern.size());
+		bound.set_pattern(pattern);
 	}
 
 	/* set the window length */ 
@@ -77,6 +152,12 @@ public:
 private:
 	string pattern;
 	int window;
+
+	lcs::LlcsCIPR<_bpc> llcs;
+	boost::shared_ptr< utilities::CharMapping<_bpc, 1, false> > pattern_mapping; ///< match bit strings for pattern
+	utilities::BitString row; ///< CIPR row, kept here to avoid mallocs
+	QGramBound<_bpc> bound; ///< upper bound for skipping windows
+	std::vector<int> bounds; ///< bounds for the current text
 };
 
 };
@@ -7,6 +7,8 @@
 #define __WL_REPORT_H__
 
 
+#include <cfloat>
+
 #include <bsp_cpp/bsp_cpp.h> 
 
 namespace windowlocal {
@@ -67,6 +69,15 @@ __attribute__ ((aligned(8)))
 /** interface for handing over window pairs to output/buffers */
 struct window_reporter {
 	virtual void report_score (window const &) = 0;
+
+	/** 
+	 * Matchers may skip windows which cannot score at least this value. 
+	 * All windows at or above the threshold must still be reported 
+	 * with their exact score.
+	 */
+	virtual double score_threshold() {
+		return -DBL_MAX;
+	}
 };
 
 /** interface for handing over window pairs to output/buffers */
@@ -75,6 +86,14 @@ struct window_translator {
 	virtual bool translate(window & w) {
 		return true;
 	}
+
+	/** 
+	 * overload to map a translated score back to the score reported 
+	 * by the matcher. This must be monotonic.
+	 */
+	virtual double untranslate_score(double score) {
+		return score;
+	}
 };
 
 
@@ -16,6 +16,7 @@
 #include "xasmlib/Queue.h"
 
 #include "report.h"
+#include "composition_bound.h"
 
 namespace windowlocal {
 
@@ -69,9 +70,32 @@ public:
 #ifdef _SEAWEEDS_VERIFY
 		pattern_orig = _pattern;
 #endif // _SEAWEEDS_VERIFY
+		bound.set_pattern(_pattern);
 	}
 
+	/**
+	 * count matches of pattern in text, report window lcs lengths
+	 *
+	 * Text blocks in which no window can reach the reporter's score
+	 * threshold are skipped. Each block needs |p| + window columns
+	 * before the first window is reported, so we only skip gaps which
+	 * are longer than that.
+	 */
 	int count(string const & text, 
+		window_reporter * rpt = NULL, 
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		if (rpt == NULL || rpt->score_threshold() == -DBL_MAX) {
+			return count_all(text, rpt, text_p0, pat_p0);
+		}
+		return count_above_threshold(*this, bound, text, (int)window,
+			rpt, text_p0, pat_p0, 
+			(int)(pattern_storage.size() + window), (int)grid_size);
+	}
+
+	/** count matches and report scores for all windows */
+	int count_all(string const & text, 
 		window_reporter * rpt = NULL, 
 		int text_p0 = 0,
 		int pat_p0 = 0
@@ -322,6 +346,7 @@ public:
 #ifdef _SEAWEEDS_VERIFY
 		pattern_orig = _pattern;
 #endif // _SEAWEEDS_VERIFY
+		bound.set_pattern(_pattern);
 	}
 
 	/* set the window length */ 
@@ -338,6 +363,9 @@ private:
 
 	/** here we store the pattern expanded to _omega bits per char */
 	utilities::IntegerVector<_omega> pattern_storage;
+
+	/** upper bound for skipping text blocks */
+	QGramBound<_bpc> bound;
 #ifdef _SEAWEEDS_VERIFY
 	string pattern_orig;
 #endif // _SEAWEEDS_VERIFY
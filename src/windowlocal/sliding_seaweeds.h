@@ -0,0 +1,122 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#ifndef __WINDOWLOCAL_SLIDING_SEAWEEDS_H__
+#define __WINDOWLOCAL_SLIDING_SEAWEEDS_H__
+
+#include "autoconfig.h"
+
+#include "xasmlib/IntegerVector.h"
+#include "seaweeds/SlidingSeaweeds.h"
+
+#include "report.h"
+#include "composition_bound.h"
+
+namespace windowlocal {
+
+/**
+ * \brief Window-local LCS in one streaming pass over the text.
+ *
+ * Uses seaweeds::SlidingSeaweeds: every text character is appended to
+ * the window and the first one is removed, which takes O(|p|) time per
+ * text character. Unlike SeaweedWindowLocalLCS, seaweed positions are
+ * not stored as distances in _omega bits, so there is no limit on the
+ * window length.
+ */
+template <int _bpc>
+class SlidingSeaweedWindowLocalLCS {
+public:
+	typedef utilities::IntegerVector<_bpc> string;
+
+	enum {
+		max_windowlength = 0x7fffffff,
+	};
+
+	SlidingSeaweedWindowLocalLCS(size_t _window, string const & _pattern, size_t _grid_size = 1)
+		: window(_window), grid_size(_grid_size) {
+		set_pattern(_pattern);
+	}
+
+	/**
+	 * count matches of pattern in text, report window lcs lengths
+	 *
+	 * Text blocks in which no window can reach the reporter's score
+	 * threshold are skipped. Each block needs window - 1 characters
+	 * before the first window is reported, so we only skip gaps which
+	 * are longer than that.
+	 */
+	int count(string const & text,
+		window_reporter * rpt = NULL,
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		if (rpt == NULL || rpt->score_threshold() == -DBL_MAX) {
+			return count_all(text, rpt, text_p0, pat_p0);
+		}
+		return count_above_threshold(*this, bound, text, (int)window,
+			rpt, text_p0, pat_p0, (int)window, (int)grid_size);
+	}
+
+	/** count matches and report scores for all windows */
+	int count_all(string const & text,
+		window_reporter * rpt = NULL,
+		int text_p0 = 0,
+		int pat_p0 = 0
+		) {
+		const int t = (int)text.size();
+		const int w = (int)window;
+		const int p = (int)pattern.size();
+		ASSERT(t >= w);
+
+		int count = 0;
+		sw.reset(0);
+		for (int j = 0; j < t; ++j) {
+			sw.append(text.get(j));
+			if (sw.size() > w) {
+				sw.remove();
+			}
+			if (sw.size() == w && sw.begin() % grid_size == 0) {
+				int lcslen = sw.llcs();
+				if (lcslen == p) {
+					++count;
+				}
+				if (rpt != NULL) {
+					rpt->report_score(windowlocal::window (sw.begin() + text_p0, pat_p0, (double)lcslen));
+				}
+			}
+		}
+		return count;
+	}
+
+	/** set the pattern */
+	void set_pattern(string const & _pattern) {
+		pattern = _pattern;
+		sw.set_x(_pattern);
+		bound.set_pattern(_pattern);
+	}
+
+	/** set the window length */
+	void set_windowlength(int _windowlength) {
+		window = _windowlength;
+	}
+
+private:
+	/** window length */
+	size_t window;
+
+	/** only report windows starting at multiples of grid_size */
+	size_t grid_size;
+
+	string pattern;
+
+	seaweeds::SlidingSeaweeds<_bpc> sw;
+
+	/** upper bound for skipping text blocks */
+	QGramBound<_bpc> bound;
+};
+
+};
+
+#endif
@@ -256,6 +256,17 @@ namespace utilities {
 			return (int)extractword(content.data + vwords_toUINT64s_lb(pos), bitofs(pos), value_bits);
 		}
 
+		/**
+		* copy count elements, starting at position start, to an array of ints. 
+		* This is specialised for 8, 16 and 32 bits so the compiler can vectorise 
+		* the conversion.
+		*/
+		void unpack(int * target, size_t start, size_t count) const {
+			for (size_t j = 0; j < count; ++j) {
+				target[j] = get(start + j);
+			}
+		}
+
 		/**
 		* resize the vector, preserving contents up to given size.
 		*/
@@ -528,7 +539,7 @@ namespace utilities {
 			}
 			target.zero();
 			size_t start_cpy = (start*value_bits) >> 6;
-			size_t real_copylen = min( content.size - start_cpy + 1, target.content.size);
+			size_t real_copylen = min( content.size - start_cpy, target.content.size);
 			memcpy(target.content.data, content.data + start_cpy, real_copylen*sizeof(UINT64));
 			target>>= (BYTE) ((start*value_bits) & 0x3f);
 			target.vword_len = end-start+1;
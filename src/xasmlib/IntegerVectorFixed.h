@@ -115,6 +115,27 @@
 		return ((const BYTE*)content.data)[pos];
 	}
 
+	template <> inline void IntegerVector<8>::unpack(int * target, size_t start, size_t count) const {
+		const BYTE * source = ((const BYTE*)content.data) + start;
+		for (size_t j = 0; j < count; ++j) {
+			target[j] = source[j];
+		}
+	}
+
+	template <> inline void IntegerVector<16>::unpack(int * target, size_t start, size_t count) const {
+		const WORD * source = ((const WORD*)content.data) + start;
+		for (size_t j = 0; j < count; ++j) {
+			target[j] = source[j];
+		}
+	}
+
+	template <> inline void IntegerVector<32>::unpack(int * target, size_t start, size_t count) const {
+		const DWORD * source = ((const DWORD*)content.data) + start;
+		for (size_t j = 0; j < count; ++j) {
+			target[j] = (int)source[j];
+		}
+	}
+
 	template <> inline  void IntegerVector<8>::fixending() {
 		A_memset(((BYTE*)content.data) + vword_len, 0, 8*content.size-vword_len);
 	}
@@ -44,11 +44,9 @@ public:
 
 		return max (tleft, max(ttop, ttop_left + character_score));
 */
-		if(top == left) {
-			return ttop_left + 1;
-		} else {
-			return max(tleft, ttop);
-		}
+		// no branches, so anti-diagonals can be vectorised
+		int m = max(tleft, ttop);
+		return top == left ? ttop_left + 1 : m;
 
 //		cout << "D(" << i << ", " << j << ") = " << tcurrent << "\t (c_i = " << left << ", c_j = " << top << ")" << endl;
 	}
@@ -84,17 +82,24 @@ int main(int argc, const char * argv[]) {
 	cout << "Using DP solver. " << endl;
 
 	double t0 = bsp_time();
-	int solver_score = solver(s1, s2);
+	int solver_score = solver.solve_rowmajor(s1, s2);
 	double t1 = bsp_time();
 	cout << "Time: " << t1 - t0 << endl << endl;
 
+	cout << "Using DP solver, anti-diagonals. " << endl;
+
+	t0 = bsp_time();
+	int ad_score = solver.solve_antidiagonal(s1, s2);
+	t1 = bsp_time();
+	cout << "Time: " << t1 - t0 << endl << endl;
+
 	cout << "Using standard LCS. " << endl;
 	t0 = bsp_time();
 	int std_score = (int)_lcs_std(s1, s2);
 	t1 = bsp_time();
 	cout << "Time: " << t1 - t0 << endl << endl;
 
-	cout << solver_score << " " << std_score << endl;
+	cout << solver_score << " " << ad_score << " " << std_score << endl;
 
 	return 0;
 }
@@ -17,6 +17,7 @@
 
 #include "windowlocal/naive.h"
 #include "windowlocal/naive_cipr.h"
+#include "windowlocal/composition_bound.h"
 #include "windowlocal/boasson.h"
 #include "windowlocal/seaweeds.h"
 #include "windowlocal/scorematrix.h"
@@ -102,6 +103,121 @@ typedef tuning::Timing <
 typedef TYPELIST_5(LlcsBenchmark, LlcsCIPR_with_preprocessing_Benchmark, BoassonBenchmark, SeaweedBenchmark, ScorematrixBenchmark) 
 	algorithms;
 
+/**
+ * Time one engine for a pattern of length w and windows of length w,
+ * which is the setting used for alignment plots.
+ */
+template <class _counter>
+double time_engine(int w, IntegerVector<BITSPERCHAR> const & text) {
+	IntegerVector<BITSPERCHAR> pattern(w);
+	for(size_t j = 0; j < pattern.size(); ++j) {
+		pattern[j] = rand() & 3;
+	}
+	_counter counter(w, pattern);
+
+	double t0 = bsp_time();
+	counter.count(text);
+	double t = bsp_time();
+	return t - t0;
+}
+
+/**
+ * Compare the engines which can be used for alignment plots for a range
+ * of window lengths. The Boasson matcher only gives lower bounds for the
+ * window LCS (see boasson.h), so it is timed for reference but not
+ * considered when picking the fastest exact engine.
+ */
+void compare_window_lengths(size_t textsize) {
+	static const int windows[] = { 8, 16, 32, 64, 127 };
+	static const char * names[] = { "cipr", "seaweeds" };
+
+	IntegerVector<BITSPERCHAR> text(textsize);
+	for(size_t j = 0; j < text.size(); ++j) {
+		text[j] = rand() & 3;
+	}
+
+	cout << "w\tcipr\tseaweeds\tboasson (lower bound)\tfastest exact" << endl;
+	for (size_t k = 0; k < sizeof(windows) / sizeof(int); ++k) {
+		int w = windows[k];
+		double t[2];
+		t[0] = time_engine< windowlocal::BPWindowLocalLCS<BITSPERCHAR> >(w, text);
+		t[1] = time_engine< windowlocal::SeaweedWindowLocalLCS<BITSPERCHAR, BITSPERCHAR> >(w, text);
+		double t_lb = time_engine< windowlocal::BoassonMPRAMMatcher<BITSPERCHAR> >(w, text);
+
+		int best = t[1] < t[0] ? 1 : 0;
+		cout << w << "\t" << t[0] << "\t" << t[1] << "\t" << t_lb << "\t" << names[best] << endl;
+	}
+}
+
+/** reporter which counts the windows it receives, with a fixed threshold */
+class counting_reporter : public windowlocal::window_reporter {
+public:
+	counting_reporter(double _threshold) : threshold(_threshold), reported(0) {}
+
+	void report_score(windowlocal::window const & ) {
+		++reported;
+	}
+
+	double score_threshold() {
+		return threshold;
+	}
+
+	double threshold;
+	size_t reported;
+};
+
+/**
+ * Measure how many windows the score threshold lets us skip on random
+ * DNA with windows of length 100, for thresholds between 0.7 and 0.95
+ * of the window length. "qgram" is the fraction of windows which the
+ * q-gram/composition bound rules out, "cipr" is the fraction which
+ * BPWindowLocalLCS skips, and the times are with and without a
+ * threshold.
+ */
+void measure_skip_rates(size_t textsize) {
+	static const double thresholds[] = { 0.7, 0.8, 0.85, 0.9, 0.95 };
+	const int w = 100;
+
+	IntegerVector<BITSPERCHAR> text(textsize), pattern(w);
+	for(size_t j = 0; j < text.size(); ++j) {
+		text[j] = rand() & 3;
+	}
+	for(size_t j = 0; j < pattern.size(); ++j) {
+		pattern[j] = rand() & 3;
+	}
+	const double n = (double)(textsize - w + 1);
+
+	QGramBound<BITSPERCHAR> qb;
+	qb.set_pattern(pattern);
+	std::vector<int> bounds;
+	qb.window_bounds(text, w, bounds);
+
+	windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, pattern);
+	counting_reporter all(-DBL_MAX);
+	double t0 = bsp_time();
+	bp.count(text, &all);
+	double t_all = bsp_time() - t0;
+
+	cout << "threshold\tqgram\tcipr\ttime\ttime_all" << endl;
+	for (size_t k = 0; k < sizeof(thresholds) / sizeof(double); ++k) {
+		double threshold = thresholds[k] * w;
+		size_t below = 0;
+		for (size_t j = 0; j < bounds.size(); ++j) {
+			if (bounds[j] < threshold) {
+				++below;
+			}
+		}
+
+		counting_reporter some(threshold);
+		t0 = bsp_time();
+		bp.count(text, &some);
+		double t = bsp_time() - t0;
+
+		cout << threshold << "\t" << below / n << "\t" 
+			<< 1.0 - some.reported / n << "\t" << t << "\t" << t_all << endl;
+	}
+}
+
 int main(int argc, char *argv[]) {
 	int add = 1000;
 	int NUM = 20;
@@ -134,6 +250,16 @@ int main(int argc, char *argv[]) {
 
 	cout << tdata << endl;
 
+	// optionally compare engines for different window lengths
+	if(argc > 5) {
+		compare_window_lengths((size_t)atoi(argv[5]));
+	}
+
+	// optionally measure how many windows a score threshold skips
+	if(argc > 6) {
+		measure_skip_rates((size_t)atoi(argv[6]));
+	}
+
 	return EXIT_SUCCESS;
 }
 
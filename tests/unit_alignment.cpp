@@ -0,0 +1,129 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <iostream>
+#include <string>
+
+#include "UnitTest++.h"
+
+#include "xasmlib/xasmlib.h"
+#include "alignment/StripedAlignment.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace utilities;
+using namespace alignment;
+
+namespace {
+	string random_dna(int len) {
+		const char * c = "acgt";
+		string s(len, 'a');
+		for (int j = 0; j < len; ++j) {
+			s[j] = c[rand() % 4];
+		}
+		return s;
+	}
+
+	void set_scores(const char * subst, int gap, int gap_continuation) {
+		bsp::global_options.set("alignment::PairwiseScoringOperator::subst_matrix", string(subst));
+		bsp::global_options.set("alignment::PairwiseScoringOperator::gap_score_h", gap);
+		bsp::global_options.set("alignment::PairwiseScoringOperator::gap_score_v", gap);
+		bsp::global_options.set("alignment::PairwiseScoringOperator::gap_continuation_score_h", gap_continuation);
+		bsp::global_options.set("alignment::PairwiseScoringOperator::gap_continuation_score_v", gap_continuation);
+	}
+
+	/** compare striped and scalar scores for random sequences */
+	void compare_striped(bool local, int tests, int maxlen) {
+		PairwiseScoringOperator<> op;
+		StripedAlignment<> sa(op, local);
+
+		for (int t = 0; t < tests; ++t) {
+			string a = random_dna(1 + rand() % maxlen);
+			string b = random_dna(1 + rand() % maxlen);
+			// similar sequences give long alignments and saturate more often
+			if (t & 1) {
+				b = a;
+				for (size_t j = 0; j < b.size(); j += 1 + rand() % 10) {
+					b[j] = "acgt"[rand() % 4];
+				}
+			}
+			utilities::IntegerVector<8> x = op.translate_input(a, true);
+			utilities::IntegerVector<8> y = op.translate_input(b, false);
+
+			sa.set_query(x);
+			int s1 = sa.score(y);
+			int s2 = sa.score_scalar(y);
+			CHECK_EQUAL(s2, s1);
+		}
+	}
+};
+
+TEST(Test_Striped_Alignment) {
+	init_xasmlib();
+	srand(23);
+
+	const char * dna =
+		"2 0 0 0 0 0 "
+		"0 2 0 0 0 0 "
+		"0 0 2 0 0 0 "
+		"0 0 0 2 0 0 "
+		"0 0 0 0 0 0 "
+		"0 0 0 0 0 0 ";
+	const char * dna_mismatch =
+		" 5 -4 -4 -4 0 0 "
+		"-4  5 -4 -4 0 0 "
+		"-4 -4  5 -4 0 0 "
+		"-4 -4 -4  5 0 0 "
+		" 0  0  0  0 0 0 "
+		" 0  0  0  0 0 0 ";
+
+	// linear gaps
+	set_scores(dna, -1, -1);
+	compare_striped(false, 100, 300);
+	compare_striped(true, 100, 300);
+
+	// affine gaps
+	set_scores(dna_mismatch, -10, -1);
+	compare_striped(false, 100, 300);
+	compare_striped(true, 100, 300);
+
+	// long local alignments overflow 8-bit lanes
+	{
+		PairwiseScoringOperator<> op;
+		StripedAlignment<> sa(op, true);
+		string a = random_dna(1000);
+		utilities::IntegerVector<8> x = op.translate_input(a, true);
+		utilities::IntegerVector<8> y = op.translate_input(a, false);
+		CHECK_EQUAL(5000, sa.score(x, y));
+#ifdef _HAVE_SSE2
+		CHECK_EQUAL(16, sa.get_lane_bits());
+#endif
+
+		// and 16-bit lanes for very long ones
+		a = random_dna(7000);
+		x = op.translate_input(a, true);
+		y = op.translate_input(a, false);
+		CHECK_EQUAL(35000, sa.score(x, y));
+		CHECK_EQUAL(32, sa.get_lane_bits());
+	}
+
+	// global scores which don't fit into 16 bits
+	{
+		PairwiseScoringOperator<> op;
+		StripedAlignment<> sa(op, false);
+		string a = random_dna(20000);
+		string b = random_dna(20);
+		utilities::IntegerVector<8> x = op.translate_input(a, true);
+		utilities::IntegerVector<8> y = op.translate_input(b, false);
+		sa.set_query(x);
+		CHECK_EQUAL(sa.score_scalar(y), sa.score(y));
+		CHECK_EQUAL(32, sa.get_lane_bits());
+	}
+
+	// restore defaults
+	set_scores(dna, -1, -1);
+}
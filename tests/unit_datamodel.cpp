@@ -154,6 +154,36 @@ namespace {
 		CHECK_EQUAL(1024 - 20 - 20, position);
 	}
 
+	TEST(Test_SequenceStreamsWindows4) {
+		utilities::init_xasmlib();
+		using namespace std;
+		using namespace utilities;
+
+		stringstream s;
+		string test =  "ACGATATACTATAACGATATACTATACGAT";
+		s << test;
+
+		datamodel::TranslatingInputStream<8> stream (s, "ACGTN");
+		datamodel::WindowedInputStream<8> winstr (3);
+		winstr.set_input ( stream );
+
+		int position = -1;
+		IntegerVector <8> testvec;
+		size_t read = winstr.get_window(20, testvec, position);
+		CHECK_EQUAL(20, read);
+
+		// the input runs out by more than the overlap
+		read = winstr.get_window(20, testvec, position);
+		CHECK_EQUAL(13, read);
+		CHECK_EQUAL(17, position);
+		testvec.resize(read);
+		CHECK_EQUAL(test.substr(17), datamodel::unwrap_sequence<8>(testvec, "ACGTN", 'X'));
+
+		// ... after which the stream must end
+		read = winstr.get_window(20, testvec, position);
+		CHECK_EQUAL(0, read);
+	}
+
 
 	TEST(Test_Transliterate) {
 		utilities::init_xasmlib();
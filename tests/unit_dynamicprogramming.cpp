@@ -0,0 +1,129 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+#include "UnitTest++.h"
+
+#include "xasmlib/xasmlib.h"
+#include "xasmlib/IntegerVector.h"
+
+#include "dynamicprogramming/DynamicProgrammingMatrixSolver.h"
+#include "lcs/Llcs.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace utilities;
+using namespace dynamic_programming;
+
+namespace {
+	/** LCS operator, branch-free */
+	class dp_test_lcs_op {
+	public:
+		inline int operator() (size_t i, size_t j,
+			UINT64 left_c,
+			UINT64 top_c,
+			int tleft,
+			int ttop_left,
+			int ttop
+		) {
+			int m = max(tleft, ttop);
+			return left_c == top_c ? ttop_left + 1 : m;
+		}
+
+		inline int init_l() {
+			return 0;
+		}
+
+		inline int init_t() {
+			return 0;
+		}
+	};
+
+	/** asymmetric operator with distinct boundary values */
+	class dp_test_asym_op {
+	public:
+		inline int operator() (size_t i, size_t j,
+			UINT64 left_c,
+			UINT64 top_c,
+			int tleft,
+			int ttop_left,
+			int ttop
+		) {
+			return max(max(tleft - 1, ttop - 3),
+				ttop_left + (left_c == top_c ? 5 : -2) + (int)(i % 3) - (int)(j % 2));
+		}
+
+		inline int init_l() {
+			return -7;
+		}
+
+		inline int init_t() {
+			return 2;
+		}
+	};
+
+	template <class _op>
+	void compare_solvers(int m, int n, int alphabet) {
+		IntegerVector<8> s1(m), s2(n);
+		for (int j = 0; j < m; ++j) {
+			s1[j] = rand() % alphabet;
+		}
+		for (int j = 0; j < n; ++j) {
+			s2[j] = rand() % alphabet;
+		}
+
+		DynamicProgrammingMatrixSolver<IntegerVector<8>, int, _op> rowmajor, antidiagonal;
+
+		int r1 = rowmajor.solve_rowmajor(s1, s2);
+		int r2 = antidiagonal.solve_antidiagonal(s1, s2);
+		CHECK_EQUAL(r1, r2);
+
+		// right column
+		for (int i = 1; i <= m; ++i) {
+			CHECK_EQUAL((*rowmajor.cur_left_col)[i], (*antidiagonal.cur_left_col)[i]);
+		}
+	}
+};
+
+namespace dynamic_programming {
+	template <>
+	struct dp_operator_traits<dp_test_lcs_op> {
+		enum {
+			antidiagonal = 1,
+		};
+	};
+};
+
+TEST(Test_DP_Antidiagonal) {
+	init_xasmlib();
+	srand(42);
+
+	for (int t = 0; t < 200; ++t) {
+		int m = rand() % 40;
+		int n = rand() % 40;
+		compare_solvers<dp_test_lcs_op>(m, n, 4);
+		compare_solvers<dp_test_asym_op>(m, n, 4);
+	}
+
+	for (int t = 0; t < 20; ++t) {
+		int m = 1 + rand() % 300;
+		int n = 1 + rand() % 300;
+		IntegerVector<8> s1(m), s2(n);
+		for (int j = 0; j < m; ++j) {
+			s1[j] = rand() % 4;
+		}
+		for (int j = 0; j < n; ++j) {
+			s2[j] = rand() % 4;
+		}
+		DynamicProgrammingMatrixSolver<IntegerVector<8>, int, dp_test_lcs_op> solver;
+		lcs::Llcs< IntegerVector<8> > llcs;
+		CHECK_EQUAL((int)llcs(s1, s2), solver(s1, s2));
+	}
+}
@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 #include "UnitTest++.h"
 
@@ -87,6 +88,235 @@ namespace {
 		test_score<PSSM_Multiplicative_Score<stored_sequence, 4>, PSSM<4> >(testpssm, ms_sascha_zc, 100, 500, "examples/pssms/profile_multiplicative_sascha_zc.dat");
 	}
 
+	TEST(Test_PSSM_Batch_Scoring) {
+		PSSM <4> testpssm; 
+		istringstream str (test_pssm_json());
+		str >> testpssm;
+
+		MarkovModel<2> mm;
+		stored_sequence v;
+		v = mm.generate_sequence(1000);
+		// unknown characters, including a window without any known ones
+		for (int k = 100; k < 120; ++k) {
+			v[k] = 4;
+		}
+		v[500] = 4;
+
+		PSSM_Multiplicative_Score<stored_sequence, 4> ms (testpssm, PSSM<4>::PSEUDOCOUNT_NONE);
+		PSSM_Score<stored_sequence> & sc (ms);
+
+		int count = 1000 - testpssm.get_length() - 10;
+		vector<double> scores (count);
+		sc.score_all(v, 10, 10 + count, &scores[0]);
+		for (int k = 0; k < count; ++k) {
+			CHECK_CLOSE(ms.score(v, k + 10), scores[k], 1e-12);
+		}
+		CHECK_EQUAL(0, scores[105 - 10]);
+	}
+
+	struct Scan_Hits {
+		void operator() (int m, int k, double score) {
+			hits.push_back(m);
+			hits.push_back(k);
+			scores.push_back(score);
+		}
+		vector<int> hits;
+		vector<double> scores;
+	};
+
+	TEST(Test_PSSM_Multi_Scanner) {
+		PSSM <4> testpssm, jaspar;
+		istringstream str (test_pssm_json());
+		str >> testpssm;
+		istringstream str2 (test_pssm_jaspar());
+		jaspar.load_jaspar_pssm(str2);
+
+		MarkovModel<2> mm;
+		stored_sequence v;
+		v = mm.generate_sequence(2000);
+		for (int k = 700; k < 720; ++k) {
+			v[k] = 4;
+		}
+		testpssm.random_sequence (v, 300);
+
+		typedef PSSM_Multiplicative_Score<stored_sequence, 4> score_t;
+		vector<score_t> scores;
+		scores.push_back(score_t (testpssm, PSSM<4>::PSEUDOCOUNT_NONE));
+		scores.push_back(score_t (jaspar, PSSM<4>::PSEUDOCOUNT_SQRT));
+		scores.push_back(score_t (testpssm, PSSM<4>::PSEUDOCOUNT_BIFA));
+		scores.push_back(score_t (testpssm, PSSM<4>::PSEUDOCOUNT_LINEAR));
+		// lookahead is used for non-negative thresholds
+		double thresholds[] = { 0.5, 0.6, -1, 0.95 };
+
+		PSSM_Multi_Scanner<stored_sequence, 4> scanner;
+		for (size_t m = 0; m < scores.size(); ++m) {
+			CHECK_EQUAL((int)m, scanner.add(scores[m], thresholds[m]));
+		}
+
+		for (int lookahead = 0; lookahead < 2; ++lookahead) {
+			scanner.set_lookahead(lookahead != 0);
+			// scan a range which doesn't start at zero and spans several tiles
+			int from = 13, to = 1990;
+			Scan_Hits sh;
+			scanner.scan(v, from, to, sh);
+
+			Scan_Hits expected;
+			for (size_t m = 0; m < scores.size(); ++m) {
+				for (int k = from; k + (int)scores[m].min_length() <= to; ++k) {
+					double s = scores[m].score(v, k);
+					if (s > thresholds[m]) {
+						expected(m, k, s);
+					}
+				}
+			}
+			// the scanner reports hits by tiles, sort by matrix first
+			vector< pair< pair<int, int>, double> > a, b;
+			for (size_t j = 0; j < sh.scores.size(); ++j) {
+				a.push_back(make_pair(make_pair(sh.hits[2*j], sh.hits[2*j+1]), sh.scores[j]));
+			}
+			for (size_t j = 0; j < expected.scores.size(); ++j) {
+				b.push_back(make_pair(make_pair(expected.hits[2*j], expected.hits[2*j+1]), expected.scores[j]));
+			}
+			sort(a.begin(), a.end());
+			CHECK_EQUAL(b.size(), a.size());
+			for (size_t j = 0; j < min(a.size(), b.size()); ++j) {
+				CHECK(a[j].first == b[j].first);
+				CHECK_EQUAL(b[j].second, a[j].second);
+			}
+			// the planted site is found
+			CHECK(a.size() > 0 && a[0].first.first == 0);
+		}
+	}
+
+	TEST(Test_PSSM_Multi_Scanner_Reverse_Strand) {
+		PSSM <4> testpssm;
+		istringstream str (test_pssm_json());
+		str >> testpssm;
+
+		MarkovModel<2> mm;
+		stored_sequence v, rc;
+		v = mm.generate_sequence(1000);
+		v[200] = 4;
+		testpssm.random_sequence (v, 500);
+		rc = v;
+		datamodel::reverse_complement<8>(rc, 4);
+
+		typedef PSSM_Multiplicative_Score<stored_sequence, 4> score_t;
+		score_t sc (testpssm, PSSM<4>::PSEUDOCOUNT_SQRT);
+		int len = (int)sc.min_length();
+
+		for (int lookahead = 0; lookahead < 2; ++lookahead) {
+			PSSM_Multi_Scanner<stored_sequence, 4> scanner;
+			scanner.set_lookahead(lookahead != 0);
+			scanner.add_reverse_complement(sc, lookahead ? 0.5 : -1);
+
+			Scan_Hits sh;
+			scanner.scan(v, 0, 1000, sh);
+
+			size_t h = 0;
+			for (int k = 0; k + len <= 1000; ++k) {
+				// forward window k is window 1000 - len - k on the reverse strand
+				double s = sc.score(rc, 1000 - len - k);
+				if (s > (lookahead ? 0.5 : -1)) {
+					CHECK(h < sh.scores.size());
+					if (h < sh.scores.size()) {
+						CHECK_EQUAL(k, sh.hits[2*h+1]);
+						CHECK_EQUAL(s, sh.scores[h]);
+					}
+					++h;
+				}
+			}
+			CHECK_EQUAL(h, sh.scores.size());
+		}
+	}
+
+	TEST(Test_PSSM_Exact_Histogram) {
+		PSSM <4> testpssm; 
+		istringstream str (test_pssm_json());
+		str >> testpssm;
+
+		PSSM_Multiplicative_Score<IntegerVector<8>, 4> bs (testpssm);
+		const int len = (int)bs.min_length();
+
+		// doubly stochastic transitions, so contexts are uniformly distributed
+		MarkovModel<2, 8> mm;
+		const double tp[4] = { 0.4, 0.3, 0.2, 0.1 };
+		for (int s = 0; s < 4; ++s) {
+			for (int c = 0; c < 4; ++c) {
+				mm.observe_transition(s, c, (size_t)(10 * tp[(c + s) % 4]));
+			}
+		}
+
+		PSSM_Histogram< IntegerVector<8> > hist;
+		hist.make_histogram(&bs, &mm);
+
+		// enumerate all words to get the reference distribution
+		vector<double> ref (PSSM_HIST_NBUCKETS, 0.0);
+		IntegerVector<8> word (len);
+		for (int w = 0; w < (1 << (2 * len)); ++w) {
+			for (int i = 0; i < len; ++i) {
+				word[i] = (w >> (2 * i)) & 3;
+			}
+			double p = 0;
+			for (int s = 0; s < 4; ++s) {
+				p += 0.25 * tp[(word[0] + s) % 4];
+			}
+			for (int i = 1; i < len; ++i) {
+				p *= tp[(word[i] + word[i - 1]) % 4];
+			}
+			ref[(size_t)(bs.score(word) * (PSSM_HIST_NBUCKETS - 1))] += p;
+		}
+		for (int j = PSSM_HIST_NBUCKETS-2; j >= 0; --j) {
+			ref[j] += ref[j+1];
+		}
+
+		// rounding can move scores by less than one bucket
+		for (int j = 1; j < PSSM_HIST_NBUCKETS - 1; ++j) {
+			double rt = hist.right_tail((j + 0.5) / (PSSM_HIST_NBUCKETS - 1));
+			CHECK(rt <= ref[j - 1] * (1 + 1e-9));
+			CHECK(rt >= ref[j + 1] * (1 - 1e-9));
+		}
+		CHECK_CLOSE(ref[PSSM_HIST_NBUCKETS - 1], hist.right_tail(1.0), 1e-9 * ref[PSSM_HIST_NBUCKETS - 1]);
+		CHECK(hist.right_tail(1.0) > 0);
+	}
+
+	TEST(Test_PSSM_Fast_Distances) {
+		srand(42);
+		vector< PSSM<4> > ps (12);
+		vector< PSSM_Distance_Columns<4> > cols (ps.size());
+		for (size_t m = 0; m < ps.size(); ++m) {
+			ps[m].set_length(1 + rand() % 12);
+			for (int i = 0; i < ps[m].get_length(); ++i) {
+				double sum = 0;
+				for (int j = 0; j < 4; ++j) {
+					// some zeros to check entries which are skipped in KL
+					ps[m](i, j) = (rand() % 5 == 0) ? 0 : rand() % 100 + 1;
+					sum += ps[m](i, j);
+				}
+				for (int j = 0; j < 4; ++j) {
+					ps[m](i, j) = sum > 0 ? ps[m](i, j) / sum : 0.25;
+				}
+			}
+			cols[m].set(ps[m]);
+		}
+
+		Both_Strands_DNA_Min_KullbackLeibler_Distance kl;
+		Both_Strands_DNA_Min_Hellinger_Distance hd;
+		Fast_Both_Strands_DNA_Min_KullbackLeibler_Distance fast_kl;
+		Fast_Both_Strands_DNA_Min_Hellinger_Distance fast_hd;
+		for (size_t a = 0; a < ps.size(); ++a) {
+			for (size_t b = 0; b < ps.size(); ++b) {
+				double d = kl(ps[a], ps[b]);
+				CHECK_CLOSE(d, fast_kl(cols[a], cols[b]), 1e-9 * (1 + fabs(d)));
+				d = hd(ps[a], ps[b]);
+				CHECK_CLOSE(d, fast_hd(cols[a], cols[b]), 1e-9 * (1 + fabs(d)));
+				// both distances are symmetric
+				CHECK_EQUAL(fast_kl(cols[a], cols[b]), fast_kl(cols[b], cols[a]));
+				CHECK_EQUAL(fast_hd(cols[a], cols[b]), fast_hd(cols[b], cols[a]));
+			}
+		}
+	}
+
 	SUITE(Lengthy) {
 
 	TEST(Test_Profile_Serialization) {
@@ -0,0 +1,271 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <boost/filesystem.hpp>
+
+#include "UnitTest++.h"
+
+#include "apps/PSSM/PSSM_Tool.h"
+#include "apps/PSSM/ProfileDB.h"
+
+using namespace UnitTest;
+
+/** PSSM_Tool.cpp is not linked into the unit tests */
+std::vector < pssm > g_pssms;
+pssmsequencemodel g_background;
+std::string g_background_id;
+
+namespace {
+
+	namespace po = boost::program_options;
+	namespace fs = boost::filesystem;
+
+	template <class T>
+	void set_option(po::variables_map & vm, const char * name, T const & value) {
+		vm.erase(name);
+		vm.insert(std::make_pair(std::string(name), po::variable_value(boost::any(value), false)));
+	}
+
+	/** hits sorted by position, strand and score */
+	struct hit_key {
+		long int five_prime_pos;
+		long int three_prime_pos;
+		std::string strand;
+		double score;
+
+		bool operator< (hit_key const & rhs) const {
+			if (five_prime_pos != rhs.five_prime_pos) {
+				return five_prime_pos < rhs.five_prime_pos;
+			}
+			if (three_prime_pos != rhs.three_prime_pos) {
+				return three_prime_pos < rhs.three_prime_pos;
+			}
+			return strand < rhs.strand;
+		}
+	};
+
+	void hit_keys(std::vector<Motif_Hit> const & hits, std::vector<hit_key> & keys) {
+		keys.resize(hits.size());
+		for (size_t k = 0; k < hits.size(); ++k) {
+			keys[k].five_prime_pos = hits[k].five_prime_pos;
+			keys[k].three_prime_pos = hits[k].three_prime_pos;
+			keys[k].strand = hits[k].strand;
+			keys[k].score = hits[k].score;
+		}
+		std::sort(keys.begin(), keys.end());
+	}
+
+	TEST(Test_PSSM_Score_Processors) {
+		utilities::init_xasmlib();
+		using namespace std;
+
+		static const char * jaspar[] = {
+			">MA0001.1 AGL3\nA  [ 0  3 79 40 66 48 65 11 65  0 ]\nC  [94 75  4  3  1  2  5  2  3  3 ]\nG  [ 1  0  3  4  1  0  5  3 28 88 ]\nT  [ 2 19 11 50 29 47 22 81  1  6 ]",
+			">T0001 T1\nA  [10 80  5  5 70 ]\nC  [80  5  5 10 10 ]\nG  [ 5  5 80 80 10 ]\nT  [ 5 10 10  5 10 ]",
+			">T0002 T2\nA  [ 5  5 60 20 20 10 80 ]\nC  [ 5 80 20 20 20 10  5 ]\nG  [85  5 10 40 20 70 10 ]\nT  [ 5 10 10 20 40 10  5 ]",
+		};
+		g_pssms.clear();
+		for (size_t j = 0; j < sizeof(jaspar) / sizeof(const char *); ++j) {
+			istringstream in (jaspar[j]);
+			pssm p;
+			p.load_jaspar_pssm(in);
+			g_pssms.push_back(p);
+		}
+		g_background = pssmsequencemodel(new pssmmarkovmodel());
+		g_background_id = "default";
+
+		fs::path profiles = fs::temp_directory_path() / fs::unique_path();
+		fs::create_directories(profiles);
+
+		string sequence;
+		for (int j = 0; j < 3000; ++j) {
+			sequence += "ACGT"[rand() & 3];
+		}
+
+		static const char * splits[] = { "pssms", "sequence" };
+		for (int s = 0; s < 2; ++s) {
+			po::variables_map vm;
+			set_option(vm, "scoretype", string("mult sqrt"));
+			set_option(vm, "profiles", profiles.string());
+			set_option(vm, "pval", 0.01);
+			set_option(vm, "fragmentsize", (size_t)200);
+			set_option(vm, "split", string(splits[s]));
+			PSSM_ScoreApp::set_parameters(vm);
+
+			vector< vector<hit_key> > reference (g_pssms.size());
+			size_t total = 0;
+			for (int P = 1; P <= 3; ++P) {
+				istringstream in (sequence);
+				vector< vector<Motif_Hit> > motifs;
+				PSSM_ScoreApp::score(in, motifs, P);
+				CHECK_EQUAL(g_pssms.size(), motifs.size());
+
+				for (size_t j = 0; j < motifs.size(); ++j) {
+					vector<hit_key> keys;
+					hit_keys(motifs[j], keys);
+					// windows in the overlap of two fragments are reported once
+					for (size_t k = 1; k < keys.size(); ++k) {
+						CHECK(keys[k-1] < keys[k]);
+					}
+					if (P == 1) {
+						reference[j] = keys;
+						total += keys.size();
+						continue;
+					}
+					CHECK_EQUAL(reference[j].size(), keys.size());
+					for (size_t k = 0; k < min(keys.size(), reference[j].size()); ++k) {
+						CHECK_EQUAL(reference[j][k].five_prime_pos, keys[k].five_prime_pos);
+						CHECK_EQUAL(reference[j][k].three_prime_pos, keys[k].three_prime_pos);
+						CHECK_EQUAL(reference[j][k].strand, keys[k].strand);
+						CHECK_CLOSE(reference[j][k].score, keys[k].score, 1e-10);
+					}
+				}
+			}
+			CHECK(total > 0);
+			PSSM_ScoreApp::cleanup();
+		}
+
+		g_pssms.clear();
+		fs::remove_all(profiles);
+	}
+
+	/** a histogram with tail scores which are exact as floats */
+	void make_tail_scores(pssmhistogram & hist, int k) {
+		std::vector<double> ts (PSSM_HIST_NBUCKETS);
+		for (size_t j = 0; j < ts.size(); ++j) {
+			ts[j] = (double)((PSSM_HIST_NBUCKETS - j) * k);
+		}
+		hist.set_tail_scores(ts.begin(), ts.end());
+	}
+
+	bool same_tail_scores(pssmhistogram const & h1, pssmhistogram const & h2) {
+		return h1.get_tail_scores() == h2.get_tail_scores();
+	}
+
+	/** overwrite bytes in a file */
+	void patch_file(std::string const & filename, size_t offset, const void * data, size_t len) {
+		std::fstream f (filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+		f.seekp(offset);
+		f.write((const char *)data, len);
+	}
+
+	TEST(Test_PSSM_Profile_DB) {
+		using namespace std;
+
+		fs::path dir = fs::temp_directory_path() / fs::unique_path();
+		fs::create_directories(dir);
+		string filename = (dir / "profiles.db").string();
+
+		pssmhistogram h1, h2, h3, h;
+		make_tail_scores(h1, 1);
+		make_tail_scores(h2, 2);
+		make_tail_scores(h3, 3);
+
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(!db.find("b", h));
+
+			// new histograms can be found before they are written
+			db.add("b", h2);
+			CHECK(db.find("b", h));
+			CHECK(same_tail_scores(h, h2));
+
+			// histograms of the wrong size are not added
+			pssmhistogram small;
+			small.set_tail_scores(h1.get_tail_scores().begin(), h1.get_tail_scores().begin() + 10);
+			db.add("x", small);
+			CHECK(!db.find("x", h));
+
+			db.flush();
+			CHECK(fs::exists(filename));
+			CHECK(db.find("b", h));
+			CHECK(same_tail_scores(h, h2));
+			CHECK(!db.find("a", h));
+
+			// entries from the file and new ones are merged
+			db.add("a", h1);
+			db.add("c", h3);
+			db.flush();
+			CHECK(db.find("a", h));
+			CHECK(same_tail_scores(h, h1));
+			CHECK(db.find("b", h));
+			CHECK(same_tail_scores(h, h2));
+			CHECK(db.find("c", h));
+			CHECK(same_tail_scores(h, h3));
+		}
+
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(db.find("a", h));
+			CHECK(same_tail_scores(h, h1));
+			CHECK(db.find("b", h));
+			CHECK(same_tail_scores(h, h2));
+			CHECK(db.find("c", h));
+			CHECK(same_tail_scores(h, h3));
+			CHECK(!db.find("d", h));
+			CHECK(!db.find("", h));
+		}
+
+		// the file starts with an 8 byte magic, a UINT32 version,
+		// a UINT32 bucket count and a UINT64 entry count.
+		string good = filename + ".good";
+		fs::copy_file(filename, good);
+
+		// wrong magic
+		patch_file(filename, 0, "XXXX", 4);
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(!db.find("a", h));
+
+			// the database is written from scratch
+			db.add("d", h1);
+			db.flush();
+		}
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(db.find("d", h));
+			CHECK(same_tail_scores(h, h1));
+			CHECK(!db.find("a", h));
+		}
+
+		// incompatible version
+		fs::remove(filename);
+		fs::copy_file(good, filename);
+		UINT32 version = 1000;
+		patch_file(filename, 8, &version, sizeof(UINT32));
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(!db.find("a", h));
+		}
+
+		// more entries than fit into the file
+		fs::remove(filename);
+		fs::copy_file(good, filename);
+		UINT64 entries = 1000000;
+		patch_file(filename, 16, &entries, sizeof(UINT64));
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(!db.find("b", h));
+		}
+
+		// truncated after the header and the three index entries
+		fs::remove(filename);
+		fs::copy_file(good, filename);
+		fs::resize_file(filename, 24 + 3*3*sizeof(UINT64));
+		{
+			PSSM_Profile_DB db (filename);
+			CHECK(!db.find("c", h));
+		}
+
+		fs::remove_all(dir);
+	}
+}
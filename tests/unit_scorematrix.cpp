@@ -0,0 +1,303 @@
+/***************************************************************************
+ *   Copyright (C) 2012   Peter Krusche, The University of Warwick         *
+ *   pkrusche@gmail.com                                                    *
+ ***************************************************************************/
+
+#include "autoconfig.h"
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+
+#include <boost/filesystem.hpp>
+
+#include "UnitTest++.h"
+
+#include "xasmlib/IntegerVector.h"
+#include "lcs/Llcs.h"
+#include "seaweeds/ScoreMatrix.h"
+#include "seaweeds/MultiSeaweeds.h"
+#include "seaweeds/SlidingSeaweeds.h"
+#include "apps/Seaweeds/SemiLocalLCS_Parallel.h"
+
+using namespace UnitTest;
+using namespace std;
+using namespace utilities;
+
+typedef seaweeds::ScoreMatrix<
+	seaweeds::ImplicitStorage<
+		seaweeds::Seaweeds<16, 8>
+	>
+> scorematrix;
+
+namespace {
+	scorematrix::string random_string(size_t len, int alphabet = 4) {
+		scorematrix::string s(len);
+		for (size_t j = 0; j < len; ++j) {
+			s[j] = rand() % alphabet;
+		}
+		return s;
+	}
+
+	/** record all window scores */
+	struct window_scores {
+		void operator()(size_t pos, double score) {
+			if (scores.size() <= pos) {
+				scores.resize(pos + 1, -1);
+			}
+			scores[pos] = score;
+		}
+		std::vector<double> scores;
+	};
+
+	TEST(Test_ImplicitStorage_Windows) {
+		init_xasmlib();
+		lcs::Llcs<scorematrix::string> llcs;
+
+		for (int k = 0; k < 100; ++k) {
+			int m = 1 + rand() % 20;
+			int n = m + rand() % 40;
+			int w = 1 + rand() % n;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y (random_string(n));
+
+			scorematrix sm(m, n);
+			sm.semilocallcs(x, y);
+
+			window_scores ws;
+			sm.query_y_windows(w, &ws);
+
+			CHECK_EQUAL((size_t)(n - w + 1), ws.scores.size());
+			for (int j = 0; j + w <= n; ++j) {
+				CHECK_EQUAL((double)llcs(x, y.substr(j, w)), ws.scores[j]);
+			}
+		}
+	}
+
+	TEST(Test_ImplicitStorage_Incremental) {
+		init_xasmlib();
+
+		for (int k = 0; k < 100; ++k) {
+			int m = 1 + rand() % 20;
+			int n = 1 + rand() % 40;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y (random_string(n));
+			scorematrix::string x2 (random_string(1 + rand() % 5));
+			scorematrix::string y2 (random_string(1 + rand() % 5));
+
+			scorematrix sm(m, n);
+			sm.semilocallcs(x, y);
+			sm.incremental_semilocallcs(x2, scorematrix::APPEND_TO_X);
+			sm.incremental_semilocallcs(y2, scorematrix::APPEND_TO_Y);
+
+			x.append(x2);
+			y.append(y2);
+			scorematrix ref((int)x.size(), (int)y.size());
+			ref.semilocallcs(x, y);
+
+			CHECK(sm.equals(ref));
+		}
+	}
+
+	TEST(Test_ImplicitStorage_Prepend) {
+		init_xasmlib();
+
+		for (int k = 0; k < 100; ++k) {
+			int m = 1 + rand() % 20;
+			int n = 1 + rand() % 40;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y (random_string(n));
+			scorematrix::string x2 (random_string(1 + rand() % 5));
+			scorematrix::string y2 (random_string(1 + rand() % 5));
+
+			scorematrix sm(m, n);
+			sm.semilocallcs(x, y);
+			sm.incremental_semilocallcs(x2, scorematrix::PREPEND_TO_X);
+			sm.incremental_semilocallcs(y2, scorematrix::PREPEND_TO_Y);
+
+			x2.append(x);
+			y2.append(y);
+			scorematrix ref((int)x2.size(), (int)y2.size());
+			ref.semilocallcs(x2, y2);
+
+			CHECK(sm.equals(ref));
+		}
+	}
+
+	TEST(Test_SlidingSeaweeds) {
+		init_xasmlib();
+		lcs::Llcs<scorematrix::string> llcs;
+
+		for (int k = 0; k < 50; ++k) {
+			int m = rand() % 20;
+			int w = 1 + rand() % 30;
+			int n = w + rand() % 100;
+			int alphabet = 1 + rand() % 4;
+			scorematrix::string x (random_string(m, alphabet));
+			scorematrix::string y (random_string(n, alphabet));
+
+			// slide a window of length w along y, appending at the back
+			// and removing at the front
+			seaweeds::SlidingSeaweeds<8> sw(x);
+			for (int j = 0; j < n; ++j) {
+				sw.append(y.get(j));
+				if (sw.size() > w) {
+					sw.remove();
+				}
+				CHECK_EQUAL(llcs(x, y.substr(sw.begin(), sw.size())), (size_t)sw.llcs());
+			}
+
+			// shrink the window to nothing
+			while (sw.size() > 0) {
+				sw.remove();
+				CHECK_EQUAL(llcs(x, y.substr(sw.begin(), sw.size())), (size_t)sw.llcs());
+			}
+
+			// the transposed case: slide along x against a fixed y, 
+			// starting from another stream position
+			int wx = 1 + rand() % (m + 1);
+			sw.set_x(y);
+			sw.reset(100);
+			for (int j = 0; j < m; ++j) {
+				sw.append(x.get(j));
+				if (sw.size() > wx) {
+					sw.remove();
+				}
+				CHECK_EQUAL(llcs(x.substr(sw.begin() - 100, sw.size()), y), (size_t)sw.llcs());
+			}
+		}
+	}
+
+	TEST(Test_ImplicitStorage_Concatenate) {
+		init_xasmlib();
+
+		for (int k = 0; k < 100; ++k) {
+			int m = 1 + rand() % 20;
+			int n1 = 1 + rand() % 40;
+			int n2 = 1 + rand() % 40;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y1 (random_string(n1));
+			scorematrix::string y2 (random_string(n2));
+
+			scorematrix sm(m, n1);
+			sm.semilocallcs(x, y1);
+			scorematrix sm2(m, n2);
+			sm2.semilocallcs(x, y2);
+			CHECK(sm.concatenate_y(sm2));
+
+			y1.append(y2);
+			scorematrix ref(m, n1 + n2);
+			ref.semilocallcs(x, y1);
+			sm.get_x() = x;
+
+			CHECK(sm.equals(ref));
+		}
+	}
+
+	TEST(Test_SemiLocalLCS_Parallel) {
+		init_xasmlib();
+		typedef SemiLocalLCS_Parallel<scorematrix> parallel_slcs;
+
+		for (int k = 0; k < 20; ++k) {
+			int m = 1 + rand() % 20;
+			// also test inputs where y is shorter than the number of 
+			// processors
+			int n = 1 + rand() % ((k % 2 == 0) ? 6 : 100);
+			std::string x, y;
+			for (int j = 0; j < m; ++j) {
+				x.push_back((char)(rand() % 4));
+			}
+			for (int j = 0; j < n; ++j) {
+				y.push_back((char)(rand() % 4));
+			}
+
+			scorematrix ref(m, n);
+			ref.semilocallcs(scorematrix::string(x), scorematrix::string(y));
+
+			for (int P = 1; P <= 5; ++P) {
+				bsp::Runner<parallel_slcs> r(P);
+				r.set_inputs(x, y);
+				r.run();
+				CHECK(parallel_slcs::result_ready());
+				for (int j = 0; j < m + n; ++j) {
+					CHECK_EQUAL(ref.get_archive()[j], parallel_slcs::get_result()[j]);
+				}
+			}
+		}
+	}
+
+	TEST(Test_ImplicitStorage_ArchiveCache) {
+		init_xasmlib();
+
+		namespace fs = boost::filesystem;
+		fs::path dir = fs::temp_directory_path() / fs::unique_path();
+		fs::create_directories(dir);
+		seaweeds::ArchiveCache::set_directory(dir.string());
+		for (int k = 0; k < 20; ++k) {
+			int m = 1 + rand() % 20;
+			int n = 1 + rand() % 40;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y (random_string(n));
+
+			scorematrix ref(m, n);
+			ref.semilocallcs(x, y);
+
+			UINT64 check;
+			std::string fn = seaweeds::ArchiveCache::filename(x, y, 16, 8, check);
+			CHECK(fs::exists(fn));
+			scorematrix::archive a;
+			CHECK(seaweeds::ArchiveCache::load(x, y, 16, 8, a));
+			for (int j = 0; j < m + n; ++j) {
+				CHECK_EQUAL(ref.get_archive()[j], a[j]);
+			}
+			// different parameters must not hit the same entry
+			CHECK(!seaweeds::ArchiveCache::load(x, y, 8, 8, a));
+
+			// second run reads the permutation from the cache
+			scorematrix sm(m, n);
+			sm.semilocallcs(x, y);
+			CHECK(sm.equals(ref));
+		}
+		// no temporary files are left behind
+		for (fs::directory_iterator it(dir), it_end; it != it_end; ++it) {
+			CHECK_EQUAL(".swa", it->path().extension().string());
+		}
+		seaweeds::ArchiveCache::set_directory("");
+		fs::remove_all(dir);
+	}
+
+	TEST(Test_ImplicitStorage_CompressedArchive) {
+		init_xasmlib();
+
+		for (int k = 0; k < 50; ++k) {
+			int m = 1 + rand() % 100;
+			int n = 1 + rand() % 400;
+			scorematrix::string x (random_string(m));
+			scorematrix::string y (random_string(n));
+
+			scorematrix ref(m, n);
+			ref.semilocallcs(x, y);
+
+			scorematrix::compressed_archive ca;
+			ref.get_compressed_archive(ca);
+			CHECK_EQUAL((size_t)(m + n), ca.size());
+			for (int j = 0; j < m + n; ++j) {
+				CHECK_EQUAL(ref.get_archive()[j], ca[j]);
+			}
+
+			scorematrix sm(m, n, ca);
+			sm.get_x() = x;
+			sm.get_y() = y;
+			CHECK(sm.equals(ref));
+			CHECK_EQUAL(ref.score(-m, n), sm.score(-m, n));
+
+			seaweeds::MultiSeaweeds<scorematrix, scorematrix::compressed_archive> ms;
+			ms.run(&x, 1, y);
+			scorematrix sm2(m, n, ms.get_seaweedpermutation(0));
+			sm2.get_x() = x;
+			sm2.get_y() = y;
+			CHECK(sm2.equals(ref));
+		}
+	}
+};
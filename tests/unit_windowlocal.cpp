@@ -34,9 +34,14 @@ using namespace UnitTest;
 
 #include "windowlocal/naive.h"
 #include "windowlocal/naive_cipr.h"
+#include "windowlocal/multi_cipr.h"
 #include "windowlocal/boasson.h"
 #include "windowlocal/seaweeds.h"
+#include "windowlocal/sliding_seaweeds.h"
 #include "windowlocal/scorematrix.h"
+#include "windowlocal/composition_bound.h"
+#include "windowlocal/kmer_filter.h"
+#include "windowlocal/banded.h"
 
 #include "Testing.h"
 
@@ -128,7 +133,12 @@ windowlocal::ScoreMatrixWindowLocalLCS <
 BITSPERCHAR
 > ScorematrixTest;
 
-typedef TYPELIST_6(LlcsTest, LlcsCIPRTest, LlcsCIPRTest2, BoassonTest, SeaweedTest, ScorematrixTest) algorithms;
+typedef WindowLocalLCSTest<
+	windowlocal::SlidingSeaweedWindowLocalLCS<BITSPERCHAR>, 
+	BITSPERCHAR
+> SlidingSeaweedTest;
+
+typedef TYPELIST_7(LlcsTest, LlcsCIPRTest, LlcsCIPRTest2, BoassonTest, SeaweedTest, ScorematrixTest, SlidingSeaweedTest) algorithms;
 
 namespace {
 	TEST(Test_Windowlocal_LCS)
@@ -146,4 +156,422 @@ namespace {
 		> t;
 		t(add, NUM, inc);
 	}
+
+	/** collect all window scores */
+	class score_collector : public windowlocal::window_reporter {
+	public:
+		void report_score(windowlocal::window const & w) {
+			if ((int)scores.size() <= w.x0) {
+				scores.resize(w.x0 + 1, -1);
+			}
+			scores[w.x0] = w.score;
+		}
+		std::vector<double> scores;
+	};
+
+	TEST(Test_Windowlocal_BPWindowLocalLCS_Naive) {
+		init_xasmlib();
+		Llcs<bit_string> llcs;
+
+		for (int k = 0; k < 20; ++k) {
+			int p = 1 + rand() % 300;
+			int w = p + rand() % 40;
+			int n = w + rand() % 100;
+			tworandomstrings<BITSPERCHAR> rs(n);
+			rs.pattern.resize(p);
+			for (int j = 0; j < p; ++j) {
+				rs.pattern[j] = rand() & 3;
+			}
+			for (int j = 0; j < n; ++j) {
+				rs.text[j] = rand() & 3;
+			}
+
+			windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, rs.pattern);
+			score_collector c1, c2;
+			int n1 = bp.count(rs.text, &c1);
+			int n2 = bp.count_naive(rs.text, &c2);
+
+			CHECK_EQUAL(n2, n1);
+			CHECK_EQUAL(c2.scores.size(), c1.scores.size());
+			for (size_t j = 0; j < c1.scores.size(); ++j) {
+				CHECK_EQUAL(c2.scores[j], c1.scores[j]);
+				CHECK_EQUAL((double)llcs(rs.pattern, rs.text.substr(j, w)), c1.scores[j]);
+			}
+		}
+	}
+
+	/** SlidingSeaweedWindowLocalLCS has no window length limit */
+	TEST(Test_Windowlocal_SlidingSeaweeds) {
+		init_xasmlib();
+		Llcs<bit_string> llcs;
+
+		for (int k = 0; k < 10; ++k) {
+			int p = 1 + rand() % 400;
+			int w = p + rand() % 200;
+			int n = w + rand() % 100;
+			int grid = 1 + rand() % 3;
+			bit_string pattern(p), text(n);
+			for (int j = 0; j < p; ++j) {
+				pattern[j] = rand() & 3;
+			}
+			for (int j = 0; j < n; ++j) {
+				text[j] = rand() & 3;
+			}
+
+			windowlocal::SlidingSeaweedWindowLocalLCS<BITSPERCHAR> sw(w, pattern, grid);
+			score_collector c;
+			int count = sw.count(text, &c, 5);
+
+			// the last windows are not reported if they are off the grid
+			int ref_count = 0;
+			CHECK(c.scores.size() <= (size_t)(5 + n - w + 1));
+			c.scores.resize(5 + n - w + 1, -1);
+			for (int j = 0; j + w <= n; ++j) {
+				if (j % grid != 0) {
+					CHECK_EQUAL(-1.0, c.scores[5 + j]);
+					continue;
+				}
+				int l = (int)llcs(pattern, text.substr(j, w));
+				CHECK_EQUAL((double)l, c.scores[5 + j]);
+				if (l == p) {
+					++ref_count;
+				}
+			}
+			CHECK_EQUAL(ref_count, count);
+		}
+	}
+
+	/** collect window scores for several patterns */
+	class multi_score_collector : public windowlocal::window_reporter {
+	public:
+		void report_score(windowlocal::window const & w) {
+			if ((int)scores.size() <= w.x1) {
+				scores.resize(w.x1 + 1);
+			}
+			if ((int)scores[w.x1].size() <= w.x0) {
+				scores[w.x1].resize(w.x0 + 1, -1);
+			}
+			scores[w.x1][w.x0] = w.score;
+		}
+		std::vector< std::vector<double> > scores;
+	};
+
+	TEST(Test_Windowlocal_MultiBPWindowLocalLCS) {
+		init_xasmlib();
+		typedef windowlocal::MultiBPWindowLocalLCS<BITSPERCHAR, 4> multi;
+
+		for (int k = 0; k < 20; ++k) {
+			int w = 1 + rand() % 64;
+			int n = w + rand() % 100;
+			int np = 1 + rand() % multi::lanes;
+			tworandomstrings<BITSPERCHAR> rs(n);
+			for (int j = 0; j < n; ++j) {
+				rs.text[j] = rand() & 3;
+			}
+			bit_string patterns[multi::lanes];
+			for (int l = 0; l < np; ++l) {
+				patterns[l].resize(std::max(1, w - rand() % 3));
+				for (size_t j = 0; j < patterns[l].size(); ++j) {
+					patterns[l][j] = rand() & 3;
+				}
+			}
+
+			multi m(w);
+			m.set_patterns(patterns, np);
+			multi_score_collector mc;
+			int nm = m.count(rs.text, &mc, 0, 10);
+
+			int nref = 0;
+			CHECK_EQUAL((size_t)(10 + np), mc.scores.size());
+			for (int l = 0; l < np; ++l) {
+				windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, patterns[l]);
+				score_collector c;
+				nref += bp.count(rs.text, &c);
+				CHECK_EQUAL(c.scores.size(), mc.scores[10 + l].size());
+				for (size_t j = 0; j < c.scores.size(); ++j) {
+					CHECK_EQUAL(c.scores[j], mc.scores[10 + l][j]);
+				}
+			}
+			CHECK_EQUAL(nref, nm);
+		}
+	}
+
+	/** collect window scores, allow skipping below a fixed threshold */
+	class threshold_collector : public score_collector {
+	public:
+		threshold_collector(double _threshold) : threshold(_threshold) {}
+
+		double score_threshold() {
+			return threshold;
+		}
+
+		double threshold;
+	};
+
+	/** check that skipping windows below the threshold keeps all scores above it */
+	template <class _matcher>
+	void check_threshold(_matcher & m, bit_string const & text, double threshold) {
+		score_collector all;
+		threshold_collector some(threshold);
+		m.count(text, &all);
+		m.count(text, &some);
+
+		int skipped = 0;
+		for (size_t j = 0; j < all.scores.size(); ++j) {
+			if (j >= some.scores.size() || some.scores[j] < 0) {
+				CHECK(all.scores[j] < threshold);
+				++skipped;
+			} else {
+				CHECK_EQUAL(all.scores[j], some.scores[j]);
+			}
+		}
+		CHECK(skipped > 0);
+	}
+
+	TEST(Test_Windowlocal_Threshold) {
+		init_xasmlib();
+
+		for (int k = 0; k < 10; ++k) {
+			int w = 10 + rand() % 30;
+			int n = 20 * w;
+			bit_string pattern(w), text(n);
+			for (int j = 0; j < w; ++j) {
+				pattern[j] = rand() & 3;
+			}
+			// alternate between random blocks and blocks with few distinct characters
+			for (int j = 0; j < n; ++j) {
+				text[j] = ((j / (2*w)) & 1) ? (rand() & 1) : (rand() & 3);
+			}
+
+			CompositionBound<BITSPERCHAR> b;
+			b.set_pattern(pattern);
+			std::vector<int> bounds;
+			b.window_bounds(text, w, bounds);
+			CHECK_EQUAL(n - w + 1, (int)bounds.size());
+
+			QGramBound<BITSPERCHAR> qb;
+			qb.set_pattern(pattern);
+			std::vector<int> qbounds;
+			qb.window_bounds(text, w, qbounds);
+			CHECK_EQUAL(n - w + 1, (int)qbounds.size());
+
+			Llcs<bit_string> llcs;
+			for (int j = 0; j < (int)bounds.size(); j += 7) {
+				int l = (int)llcs(pattern, text.substr(j, w));
+				CHECK(l <= bounds[j]);
+				CHECK(l <= qbounds[j]);
+				CHECK(qbounds[j] <= bounds[j]);
+			}
+
+			double threshold = (double)(w - w / 4);
+
+			windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, pattern);
+			check_threshold(bp, text, threshold);
+
+			windowlocal::BoassonMPRAMMatcher<BITSPERCHAR, BOASSON_OMEGA> bo(w, pattern);
+			check_threshold(bo, text, threshold);
+
+			windowlocal::SeaweedWindowLocalLCS<BITSPERCHAR, BOASSON_OMEGA> sw(w, pattern);
+			check_threshold(sw, text, threshold);
+
+			windowlocal::SlidingSeaweedWindowLocalLCS<BITSPERCHAR> ssw(w, pattern);
+			check_threshold(ssw, text, threshold);
+
+			windowlocal::MultiBPWindowLocalLCS<BITSPERCHAR, 4> mbp(w);
+			mbp.set_patterns(&pattern, 1);
+			check_threshold(mbp, text, threshold);
+		}
+	}
+
+	/**
+	 * On random DNA, the bounds from previously computed windows let
+	 * BPWindowLocalLCS skip most windows below the threshold.
+	 */
+	TEST(Test_Windowlocal_Threshold_SkipRate) {
+		init_xasmlib();
+
+		const int w = 100, n = 20000;
+		bit_string pattern(w), text(n);
+		for (int j = 0; j < w; ++j) {
+			pattern[j] = rand() & 3;
+		}
+		for (int j = 0; j < n; ++j) {
+			text[j] = rand() & 3;
+		}
+
+		windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, pattern);
+		threshold_collector some(0.7 * w);
+		bp.count(text, &some);
+
+		int computed = 0;
+		for (size_t j = 0; j < some.scores.size(); ++j) {
+			if (some.scores[j] >= 0) {
+				++computed;
+			}
+		}
+		CHECK(computed > 0);
+		CHECK(computed < (n - w + 1) / 4);
+	}
+
+	TEST(Test_Windowlocal_KmerFilter) {
+		init_xasmlib();
+
+		for (int k = 0; k < 10; ++k) {
+			int w = 20 + rand() % 40;
+			int min_lcs = w - 1 - rand() % (w / 10);
+			int m = 300 + rand() % 200, n = 400 + rand() % 200;
+			bit_string x(m), y(n);
+			for (int j = 0; j < m; ++j) {
+				x[j] = rand() & 3;
+			}
+			for (int j = 0; j < n; ++j) {
+				y[j] = rand() & 3;
+			}
+			// plant a few mutated copies of x in y
+			for (int c = 0; c < 3; ++c) {
+				int i = rand() % (m - 2*w), j = rand() % (n - 2*w);
+				for (int l = 0; l < 2*w; ++l) {
+					y[j + l] = (rand() % 50 == 0) ? (rand() & 3) : x[i + l];
+				}
+			}
+
+			windowlocal::KmerFilter<BITSPERCHAR> f(y, w, min_lcs);
+			CHECK(f.enabled());
+
+			int block = w;
+			int found = 0;
+			std::vector< std::vector< windowlocal::KmerFilter<BITSPERCHAR>::range > > ranges;
+			windowlocal::BPWindowLocalLCS<BITSPERCHAR> bp(w, x.substr(0, w));
+			for (int i0 = 0; i0 + w <= m; i0 += block) {
+				int count = std::min(block, m - w + 1 - i0);
+				f.candidates(x, i0, count, ranges);
+				for (int i = i0; i < i0 + count; ++i) {
+					bp.set_pattern(x.substr(i, w));
+					score_collector c;
+					bp.count(y, &c);
+					for (size_t j = 0; j < c.scores.size(); ++j) {
+						if (c.scores[j] < min_lcs) {
+							continue;
+						}
+						++found;
+						bool in_range = false;
+						for (size_t r = 0; r < ranges[i - i0].size(); ++r) {
+							in_range = in_range || (ranges[i - i0][r].first <= (int)j && (int)j <= ranges[i - i0][r].second);
+						}
+						CHECK(in_range);
+					}
+				}
+			}
+			CHECK(found > 0);
+		}
+	}
+
+	/**
+	 * On unrelated random DNA, the filter must rule out most window
+	 * pairs at Filtered::threshold = 0.9.
+	 */
+	TEST(Test_Windowlocal_KmerFilter_Selectivity) {
+		init_xasmlib();
+
+		const int w = 100, m = 1000, n = 20000;
+		bit_string x(m), y(n);
+		for (int j = 0; j < m; ++j) {
+			x[j] = rand() & 3;
+		}
+		for (int j = 0; j < n; ++j) {
+			y[j] = rand() & 3;
+		}
+
+		windowlocal::KmerFilter<BITSPERCHAR> f(y, w, 90);
+		CHECK(f.enabled());
+		CHECK_EQUAL(4, f.get_k());
+
+		std::vector< std::vector< windowlocal::KmerFilter<BITSPERCHAR>::range > > ranges;
+		double candidates = 0;
+		for (int i0 = 0; i0 + w <= m; i0 += w) {
+			int count = std::min(w, m - w + 1 - i0);
+			f.candidates(x, i0, count, ranges);
+			for (int i = 0; i < count; ++i) {
+				for (size_t r = 0; r < ranges[i].size(); ++r) {
+					candidates += ranges[i][r].second - ranges[i][r].first + 1;
+				}
+			}
+		}
+		double pairs = (double)(m - w + 1) * (double)(n - w + 1);
+		CHECK(candidates / pairs < 0.05);
+	}
+
+	/** reference banded LCS of x[i..i+w) and y[i..i+w) */
+	static int banded_llcs(bit_string const & x, bit_string const & y, int i, int w, int band) {
+		std::vector< std::vector<int> > h(w + 1, std::vector<int>(w + 1, 0));
+		for (int r = 1; r <= w; ++r) {
+			for (int c = 1; c <= w; ++c) {
+				h[r][c] = std::max(h[r-1][c], h[r][c-1]);
+				if (abs(c - r) <= band && x[i + r - 1] == y[i + c - 1]) {
+					h[r][c] = std::max(h[r][c], h[r-1][c-1] + 1);
+				}
+			}
+		}
+		return h[w][w];
+	}
+
+	TEST(Test_Windowlocal_Banded) {
+		init_xasmlib();
+
+		for (int k = 0; k < 40; ++k) {
+			int w = 1 + rand() % 50;
+			int band = rand() % 32;
+			int n = w + rand() % 150;
+			bit_string x(n), y(n + rand() % 10);
+			for (int j = 0; j < n; ++j) {
+				x[j] = rand() & 3;
+			}
+			for (size_t j = 0; j < y.size(); ++j) {
+				y[j] = (j < (size_t)n && rand() % 4 != 0) ? x[j] : (rand() & 3);
+			}
+
+			windowlocal::BandedWindowLocalLCS<BITSPERCHAR> bm(w, band);
+			multi_score_collector c;
+			int nm = bm.count(x, y, &c, 0, 0);
+
+			int nref = 0;
+			for (int i = 0; i + w <= n; ++i) {
+				int ref = banded_llcs(x, y, i, w, band);
+				if (ref == w) {
+					++nref;
+				}
+				CHECK(i < (int)c.scores.size() && i < (int)c.scores[i].size());
+				if (i < (int)c.scores.size() && i < (int)c.scores[i].size()) {
+					CHECK_EQUAL((double)ref, c.scores[i][i]);
+				}
+			}
+			CHECK_EQUAL(nref, nm);
+		}
+	}
+
+	TEST(Test_Windowlocal_Boasson_SetPattern) {
+		init_xasmlib();
+		typedef windowlocal::BoassonMPRAMMatcher<BITSPERCHAR, BOASSON_OMEGA> boasson;
+
+		int w = 30;
+		bit_string text(500), pattern(20);
+		for (size_t j = 0; j < text.size(); ++j) {
+			text[j] = rand() & 3;
+		}
+		for (size_t j = 0; j < pattern.size(); ++j) {
+			pattern[j] = rand() & 3;
+		}
+		boasson reused(w, pattern);
+		for (int k = 0; k < 10; ++k) {
+			pattern.resize(15 + rand() % 10);
+			for (size_t j = 0; j < pattern.size(); ++j) {
+				pattern[j] = rand() & 3;
+			}
+			reused.set_pattern(pattern);
+			boasson fresh(w, pattern);
+			score_collector c1, c2;
+			CHECK_EQUAL(fresh.count(text, &c1), reused.count(text, &c2));
+			CHECK(c1.scores == c2.scores);
+		}
+	}
 };